@@ -11,18 +11,44 @@ SOURCES += \
     main.cpp \
     src/MainWindow.cpp \
     src/Root.cpp \
+    src/StringPool.cpp \
     src/Node.cpp \
+    src/PackedWord.cpp \
     src/BinarySearchTree.cpp \
+    src/FrozenIndex.cpp \
+    src/Bitmap.cpp \
+    src/LetterIndex.cpp \
+    src/DerivationIndex.cpp \
     src/hashtable.cpp \
     src/core_engine.cpp \
+    src/SchemeIndex.cpp \
+    src/BloomFilter.cpp \
+    src/LexiconAutomaton.cpp \
+    src/DerivationMatrix.cpp \
+    src/ThreadPool.cpp \
+    src/CorpusAnalyzer.cpp \
     src/TreeVisualizationWidget.cpp
 
 HEADERS += \
     include/Root.h \
+    include/StringPool.h \
     include/Node.h \
+    include/SlabPool.h \
+    include/PackedWord.h \
     include/BinarySearchTree.h \
+    include/FrozenIndex.h \
+    include/Bitmap.h \
+    include/LetterIndex.h \
+    include/DerivationIndex.h \
     include/hashtable.h \
     include/core_engine.h \
+    include/SchemeIndex.h \
+    include/BloomFilter.h \
+    include/LexiconAutomaton.h \
+    include/DerivationMatrix.h \
+    include/ResultCache.h \
+    include/ThreadPool.h \
+    include/CorpusAnalyzer.h \
     include/MainWindow.h \
     include/TreeVisualizationWidget.h
 
@@ -1,25 +1,63 @@
 #pragma once
 #include "./Node.h"
+#include "./FrozenIndex.h"
+#include "./LetterIndex.h"
+#include "./SlabPool.h"
+#include "./DerivationIndex.h"
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <deque>
 #include <fstream>
 #include <iostream>
 using namespace std;
 
 class BinarySearchTree {
+    SlabPool<Node> m_pool;           // owns every Node; declared first so it is destroyed last
+    SlabPool<Root> m_records;        // out-of-line Root of each Node
     Node* m_Root;
+    // Root key -> the node currently holding it. Rotations keep payloads in
+    // place; only the successor swap in deleteN moves a key to another node.
+    unordered_map<string, Node*> m_index;
+    FrozenIndex m_frozen;            // valid from freeze() until the next mutation
+    LetterIndex m_letters;           // keyed by the strings in m_index
+    DerivationIndex m_derivations;   // which scheme produced each stored derivative
+    long long m_version = 0;         // bumped whenever the set of roots changes
+    long long m_id;                  // unique per tree, so caches keyed on (id, version) never mix trees
 
-    Node* insert(Node* node, Root r);
-    Node* deleteN(Node* node, Root r);
-    Node* search(Node* node, string value);
+    // Recent root insertions and deletions, for indexes that follow the tree
+    // incrementally. At most JOURNAL_LIMIT entries are kept; a bulk load
+    // starts a new history.
+    struct root_change {
+        long long version;           // m_version after the change
+        bool added;
+        string root;
+    };
+    static const size_t JOURNAL_LIMIT = 4096;
+    deque<root_change> m_journal;
+    long long m_journalStart = 0;    // the journal covers every change after this version
+    void journal(bool added, const string& root);
+
+    Node* insert(Node* node, string_view key, packed_word packed, Root* payload, Node*& created);
+    Node* deleteN(Node* node, string_view key, packed_word packed);
+    static int compareKey(string_view key, packed_word packed, const Node* node);
+    Node* newNode(Root&& r);
+    void freeNode(Node* node);
+    Node* search(Node* node, const string& value);
     void inorder(Node* node);
     void inorder(Node* node, vector<Root>& roots);
-    void destroy(Node* node);
+    template <class Visit> static void forEach(const Node* node, Visit& visit);
+    template <class Visit> int streamRanks(int first, int last, Visit& visit, int offset, int limit) const;
+    int prefixEndRank(const string& prefix) const;
     int getHeight(Node* node);
     int getNodeCount(Node* node);
+    void updateNode(Node* node);
     void printNodeBox(Node* node, const string& prefix, bool isLeft, bool isRight);
     int getBalance(Node* y);
     Node* foundMin(Node* y);
+    Node* buildBalanced(vector<Node*>& nodes, int lo, int hi);
+    void collectNodes(vector<Node*>& nodes) const;
 
 public:
     BinarySearchTree();
@@ -28,21 +66,127 @@ public:
     Node* rotateRight(Node* y);
     Node* rotateLeft(Node* y);
     void insert(Root r);
+    void emplace(string_view rootName);
     void deleteN(Root r);
-    bool search(string value);
-    Node* getRootNode(string value);
+    bool search(const string& value) const;
+    bool contains(const string& value) const;
+    Node* getRootNode(const string& value) const;
+    // Adds word to root's derivatives and records scheme as its producer.
+    // False (and nothing stored) if root is not in the tree.
+    bool addDerivation(const string& root, const string& scheme, string_view word, int count = 1);
+    // Records scheme as another producer of word without adding to root's
+    // frequency, for a word that several schemes of one root yield.
+    bool addProducer(const string& root, const string& scheme, string_view word, int count = 1);
+    const DerivationIndex& derivations() const { return m_derivations; }
+    Node* findOrdered(const string& value) const;   // ordered descent, frozen array when available
+
+    void freeze();
+    bool isFrozen() const { return !m_frozen.empty(); }
+    long long version() const { return m_version; }
+    long long id() const { return m_id; }
+    // Calls visit(bool added, const string& root) for each change made after
+    // `version`, oldest first. False (and nothing visited) if that part of
+    // the history is gone, in which case the caller has to rebuild.
+    template <class Visit> bool changesSince(long long version, Visit visit) const;
     void display();
 
     int getHeight();
-    int getNodeCount();
+    int getNodeCount() const;
+
+    // Order statistics from the subtree sizes: O(log n) each.
+    Node* selectNode(int k) const;              // k-th root in order, 0-based
+    int rank(const string& value) const;        // roots ordered before value
+    vector<string> page(int offset, int limit) const;
     bool isEmpty();
 
     void displayStructured();
     void displayRootWithDerivatives(string rootName);
 
     bool loadRootsFromFile(const string& filename);
-    vector<Root> getAllRoots();
+    void bulkLoad(vector<string> roots);
+    vector<Root> getAllRoots();   // copies every Root; prefer forEach / begin()
+
+    // In-order walk over the stored Roots without copying them. The stack
+    // is a fixed array (an AVL tree of 2^63 nodes is still < 92 levels).
+    class const_iterator {
+        friend class BinarySearchTree;
+        const Node* m_stack[96];
+        int m_depth = 0;
+        void pushLeft(const Node* node);
+    public:
+        const_iterator() {}
+        explicit const_iterator(const Node* root) { pushLeft(root); }
+        const Root& operator*() const { return m_stack[m_depth - 1]->getRootObject(); }
+        const Root* operator->() const { return &**this; }
+        const_iterator& operator++();
+        bool operator==(const const_iterator& o) const {
+            return m_depth == o.m_depth && (m_depth == 0 || m_stack[m_depth - 1] == o.m_stack[o.m_depth - 1]);
+        }
+        bool operator!=(const const_iterator& o) const { return !(*this == o); }
+    };
+    const_iterator begin() const { return const_iterator(m_Root); }
+    const_iterator end() const { return const_iterator(); }
+
+    // Calls visit(const Root&) for every root in order.
+    template <class Visit> void forEach(Visit visit) const { forEach(m_Root, visit); }
+
+    const_iterator seek(int k) const;                   // positioned on the k-th root
+    const_iterator lowerBound(const string& key) const;
 
+    // Stream the roots in [lo, hi], or starting with prefix, to
+    // visit(const Root&) in order. The start is found from the subtree
+    // sizes, so offset costs O(log n) and only the visited roots are
+    // touched. limit < 0 means no limit; returns the number visited.
+    template <class Visit>
+    int rangeQuery(const string& lo, const string& hi, Visit visit, int offset = 0, int limit = -1) const;
+    template <class Visit>
+    int prefixQuery(const string& prefix, Visit visit, int offset = 0, int limit = -1) const;
+    int countRange(const string& lo, const string& hi) const;
+    int countPrefix(const string& prefix) const;
+
+    // Roots matching a wildcard pattern such as "?ر?" ('?' = any letter).
+    vector<string> matchPattern(const string& pattern) const { return m_letters.match(pattern); }
+    const LetterIndex& letterIndex() const { return m_letters; }
+    pool_stats nodeStats() const { return m_pool.stats(); }
+    pool_stats recordStats() const { return m_records.stats(); }
 
     Node* getRoot() const { return m_Root; }
 };
+
+template <class Visit>
+void BinarySearchTree::forEach(const Node* node, Visit& visit) {
+    while (node) {
+        forEach(node->getLeft(), visit);
+        visit(node->getRootObject());
+        node = node->getRight();
+    }
+}
+
+template <class Visit>
+bool BinarySearchTree::changesSince(long long version, Visit visit) const {
+    if (version < m_journalStart || version > m_version) return false;
+    for (const root_change& c : m_journal)
+        if (c.version > version) visit(c.added, c.root);
+    return true;
+}
+
+template <class Visit>
+int BinarySearchTree::streamRanks(int first, int last, Visit& visit, int offset, int limit) const {
+    int k = first + max(offset, 0);
+    int end = limit < 0 ? last : min(last, k + limit);
+    int visited = 0;
+    for (const_iterator it = seek(k); k < end; ++it, ++k, ++visited) visit(*it);
+    return visited;
+}
+
+template <class Visit>
+int BinarySearchTree::rangeQuery(const string& lo, const string& hi, Visit visit, int offset, int limit) const {
+    if (hi < lo) return 0;
+    int last = rank(hi) + (contains(hi) ? 1 : 0);
+    return streamRanks(rank(lo), last, visit, offset, limit);
+}
+
+template <class Visit>
+int BinarySearchTree::prefixQuery(const string& prefix, Visit visit, int offset, int limit) const {
+    return streamRanks(rank(prefix), prefixEndRank(prefix), visit, offset, limit);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+// Compressed set of 32-bit ids, split into chunks of 65536 by the high 16
+// bits. A chunk keeps its low halves as a sorted array while it holds at
+// most ARRAY_MAX ids and switches to a 65536-bit bitset once it is denser,
+// so sparse and dense sets both stay small and intersect quickly.
+class Bitmap {
+    struct Chunk {
+        unsigned short high;
+        int cardinality;
+        vector<unsigned short> array;        // sorted, while cardinality <= ARRAY_MAX
+        vector<unsigned long long> bits;     // BITSET_WORDS words otherwise
+    };
+    vector<Chunk> m_chunks;                  // sorted by high
+
+    Chunk* findChunk(unsigned short high);
+    const Chunk* findChunk(unsigned short high) const;
+    static void toBitset(Chunk& c);
+    static void toArray(Chunk& c);
+    static Chunk intersect(const Chunk& a, const Chunk& b);
+
+public:
+    static const int ARRAY_MAX    = 4096;
+    static const int BITSET_WORDS = 1024;
+
+    void add(unsigned id);
+    void remove(unsigned id);
+    bool contains(unsigned id) const;
+    size_t cardinality() const;
+    bool empty() const { return m_chunks.empty(); }
+    size_t bytes() const;
+
+    static Bitmap intersect(const Bitmap& a, const Bitmap& b);
+
+    // Calls visit(unsigned id) for every id in ascending order.
+    template <class Visit> void forEach(Visit visit) const;
+};
+
+template <class Visit>
+void Bitmap::forEach(Visit visit) const {
+    for (const Chunk& c : m_chunks) {
+        unsigned base = (unsigned)c.high << 16;
+        if (c.bits.empty()) {
+            for (unsigned short low : c.array) visit(base | low);
+            continue;
+        }
+        for (int w = 0; w < BITSET_WORDS; w++) {
+            unsigned long long word = c.bits[w];
+            while (word) {
+                visit(base | (unsigned)(w * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+}
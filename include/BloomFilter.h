@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+// Blocked Bloom filter over 64-bit hashes: the hash picks one 512-bit
+// block (a cache line) and all k bits are set or tested inside it, so a
+// query costs one memory access. Sized from the expected element count
+// and the target false-positive rate.
+class BloomFilter {
+    static const int BLOCK_WORDS = 8;
+
+    vector<unsigned long long> m_bits;
+    size_t m_blocks = 0;
+    int m_hashes = 0;
+
+public:
+    void reset(size_t expected, double fpRate);
+    void add(unsigned long long hash);
+    bool mayContain(unsigned long long hash) const;
+
+    bool empty() const { return m_blocks == 0; }
+    size_t bitCount() const { return m_bits.size() * 64; }
+    int hashCount() const { return m_hashes; }
+};
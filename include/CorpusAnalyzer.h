@@ -0,0 +1,47 @@
+#pragma once
+#include "core_engine.h"
+#include "ThreadPool.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+struct corpus_report {
+    long long bytes       = 0;
+    long long tokens      = 0;
+    long long analyzed    = 0;   // tokens with at least one (root, scheme) analysis
+    long long derivations = 0;   // distinct (root, word) pairs fed back into the tree
+    double    seconds     = 0;
+};
+
+// Streams a UTF-8 corpus in chunks through a work-stealing pool. Workers
+// only read the compiled SchemeIndex and the tree's root set and count
+// (root, word) pairs locally; the merge then adds them to each Root's
+// derivatives once the pool is drained.
+class CorpusAnalyzer {
+    struct WorkerResult {
+        unordered_map<string, long long> derivations;   // root '\t' scheme '\t' word -> count
+        long long tokens   = 0;
+        long long analyzed = 0;
+    };
+
+    struct hashmap*    m_hashmap;
+    BinarySearchTree*  m_tree;
+    ThreadPool         m_pool;
+    vector<WorkerResult> m_results;
+
+    mutex m_flowLock;
+    condition_variable m_flow;
+    unsigned m_inFlight = 0;
+
+    void analyzeChunk(const string& chunk, const SchemeIndex& index);
+    void merge(corpus_report& report);
+
+public:
+    static const size_t CHUNK_SIZE = 1 << 22;
+
+    CorpusAnalyzer(struct hashmap* hashmap_ptr, BinarySearchTree* tree, unsigned threads = 0);
+
+    bool analyzeFile(const string& filename, corpus_report& report);
+    unsigned threadCount() const { return m_pool.size(); }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "./StringPool.h"
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+// One stored derivative and the scheme that produced it. root, scheme and
+// word are ids in StringPool::global(); count 0 marks an entry whose root
+// was deleted.
+struct derivation {
+    unsigned root;
+    unsigned scheme;
+    unsigned word;
+    int count;
+};
+
+// Inverted indexes over the stored derivatives: scheme -> entries and
+// word -> entries, so "every root with a derivative from scheme S" and
+// "who produced word W" read only their own results.
+class DerivationIndex {
+    vector<derivation> m_entries;
+    unordered_map<unsigned, vector<unsigned>> m_byScheme;
+    unordered_map<unsigned, vector<unsigned>> m_byWord;
+    unordered_map<unsigned, vector<unsigned>> m_byRoot;
+    size_t m_live = 0;
+
+    template <class Visit>
+    void visitList(const unordered_map<unsigned, vector<unsigned>>& lists, string_view key, Visit& visit) const;
+
+public:
+    void record(string_view root, string_view scheme, string_view word, int count = 1);
+    void removeRoot(string_view root);
+
+    // Calls visit(const derivation&) for every live entry of the scheme / word.
+    template <class Visit> void forScheme(string_view scheme, Visit visit) const { visitList(m_byScheme, scheme, visit); }
+    template <class Visit> void forWord(string_view word, Visit visit) const { visitList(m_byWord, word, visit); }
+
+    size_t size() const { return m_live; }
+};
+
+template <class Visit>
+void DerivationIndex::visitList(const unordered_map<unsigned, vector<unsigned>>& lists, string_view key, Visit& visit) const {
+    auto it = lists.find(StringPool::global().find(key));
+    if (it == lists.end()) return;
+    for (unsigned e : it->second)
+        if (m_entries[e].count > 0) visit(m_entries[e]);
+}
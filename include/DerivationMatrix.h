@@ -0,0 +1,54 @@
+#pragma once
+#include "./StringPool.h"
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+// Generated word of every (root, scheme) pair, as a dense row-major grid
+// of ids in the matrix's own StringPool: one row per root, one column per
+// scheme. Rows and columns are added and dropped individually, so keeping
+// the grid in step with the tree and the scheme table only fills the new
+// cells. Removal moves the last row (or column) into the freed place. A
+// cell whose scheme does not fit its root holds the empty word.
+//
+// Root, scheme and word text all live in the private pool, which clear()
+// releases; words of dropped rows stay in it until then (see waste()).
+class DerivationMatrix {
+    StringPool m_words;
+    vector<unsigned> m_rowRoots;                 // root id of each row
+    vector<unsigned> m_columnSchemes;            // scheme id of each column
+    unordered_map<string_view, unsigned> m_rows; // root text (in the pool) -> row
+    unordered_map<string_view, unsigned> m_columns; // scheme text (in the pool) -> column
+    vector<unsigned> m_cells;                    // NONE until filled
+    vector<unsigned> m_tags;                     // low bits of each cell's word hash
+
+    static unsigned tag(string_view word) { return (unsigned)hash<string_view>()(word); }
+
+public:
+    size_t rows() const { return m_rowRoots.size(); }
+    size_t columns() const { return m_columnSchemes.size(); }
+    long long row(string_view root) const;       // -1 if the root has no row
+    long long column(string_view scheme) const;
+    string_view rowRoot(size_t row) const { return m_words.at(m_rowRoots[row]); }
+    string_view columnScheme(size_t column) const { return m_words.at(m_columnSchemes[column]); }
+
+    bool filled(size_t row, size_t column) const { return m_cells[row * columns() + column] != StringPool::NONE; }
+    string_view at(size_t row, size_t column) const { return m_words.at(m_cells[row * columns() + column]); }
+    void set(size_t row, size_t column, string_view word);
+    // First column of row whose word is `word`, or -1. The row's tags are
+    // compared first, so only a likely match reads the pool.
+    long long find(size_t row, string_view word) const;
+
+    size_t addRow(string_view root);
+    void removeRow(string_view root);
+    // Drops the columns missing from schemes and appends the new ones in a
+    // single relayout; returns the indexes of the appended columns.
+    vector<size_t> setColumns(const vector<string_view>& schemes);
+
+    // Pool entries the grid no longer refers to, at least: words shared by
+    // several cells are counted as live once per cell.
+    size_t waste() const;
+    void clear();
+    size_t bytes() const;                        // grid, row/column maps and the pool
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include "./Node.h"
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Read-only snapshot of the tree's keys in Eytzinger (BFS) order: slot k has
+// children 2k and 2k+1, so a search touches a handful of contiguous cache
+// lines instead of one heap Node per level. Each key is reduced to its
+// first 8 bytes packed big-endian, which orders the same way as the string;
+// the full key is only compared when two prefixes tie.
+class FrozenIndex {
+    vector<unsigned long long> m_prefix;   // 1-based, m_prefix[0] unused
+    vector<Node*> m_nodes;                 // payload of each slot
+
+    static unsigned long long prefixOf(string_view key);
+    size_t fill(const vector<Node*>& sorted, size_t next, size_t k);
+    bool less(size_t k, unsigned long long prefix, string_view key) const;
+
+public:
+    void build(const vector<Node*>& sorted);
+    void clear();
+    bool empty() const { return m_nodes.size() <= 1; }
+    size_t size() const { return m_nodes.empty() ? 0 : m_nodes.size() - 1; }
+
+    // Slot of the first key >= key, or 0 when every key is smaller.
+    size_t lowerBound(string_view key) const;
+    Node* find(string_view key) const;
+    Node* at(size_t slot) const { return m_nodes[slot]; }
+};
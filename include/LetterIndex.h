@@ -0,0 +1,41 @@
+#pragma once
+#include "./Bitmap.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+// Positional index over the roots: each root gets a small integer id, and
+// for every (radical position, letter) pair a Bitmap holds the ids of the
+// roots with that letter there. Roots are also grouped by letter count, so
+// a pattern such as "?ر?" is the intersection of the length-3 bitmap with
+// the bitmap for ر at position 1. Ids of removed roots are reused.
+class LetterIndex {
+    vector<const string*> m_keys;                // id -> key (owned by the tree), nullptr if free
+    vector<unsigned> m_free;
+    unordered_map<string_view, unsigned> m_ids;
+    unordered_map<unsigned long long, Bitmap> m_positions;   // position << 32 | code point
+    vector<Bitmap> m_lengths;                    // indexed by letter count
+
+    static unsigned long long slotKey(size_t position, unsigned letter) {
+        return ((unsigned long long)position << 32) | letter;
+    }
+
+public:
+    // key must stay at the same address until it is removed.
+    void add(const string& key);
+    void remove(const string& key);
+    void clear();
+
+    // Roots matching pattern letter by letter, '?' or '؟' matching any one
+    // letter. Sorted.
+    vector<string> match(const string& pattern) const;
+
+    size_t size() const { return m_ids.size(); }
+    size_t bitmapCount() const { return m_positions.size(); }
+    size_t bytes() const;
+
+    // Code points of a UTF-8 string.
+    static vector<unsigned> letters(string_view s);
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// One generated word for the builder: bytes [offset, offset+length) of the
+// caller's text blob, produced by root number `root` and scheme `scheme`.
+struct lexicon_word {
+    uint32_t offset;
+    uint32_t length;
+    uint32_t root;
+    uint32_t scheme;
+};
+
+// Full-form lexicon compiled into a minimal acyclic automaton over UTF-8
+// bytes. Every state stores how many words it accepts from there on, so
+// walking a word also yields its rank among all words, and the rank
+// indexes the (root, scheme) pairs that produce it.
+//
+// The file is a flat little-endian image: header, states, edges, posting
+// offsets, (root, scheme) pairs, then the root and scheme names. open()
+// maps it read-only, so processes using the same file share one copy in
+// the page cache, and checks every offset and index in it before use.
+// write() replaces the file atomically, so a mapping of the old one stays
+// valid.
+class LexiconAutomaton {
+public:
+    struct header {
+        char     magic[8];
+        uint32_t states, edges, words, pairs, roots, schemes, text;
+        uint32_t reserved;
+    };
+    struct state {
+        uint32_t first_edge;
+        uint32_t count;        // words accepted from this state
+        uint16_t edge_count;
+        uint8_t  final;
+        uint8_t  pad;
+    };
+
+    LexiconAutomaton() = default;
+    LexiconAutomaton(const LexiconAutomaton&) = delete;
+    LexiconAutomaton& operator=(const LexiconAutomaton&) = delete;
+    ~LexiconAutomaton() { close(); }
+
+    // Sorts words, builds the automaton and writes it. Returns the number
+    // of distinct words, or -1 if the file cannot be written.
+    static long long write(const string& filename, const vector<string>& roots, const vector<string>& schemes,
+                           const string& text, vector<lexicon_word>& words);
+
+    bool open(const string& filename);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+
+    // Rank of word among all words, or -1 if it is not in the lexicon.
+    long long find(string_view word) const;
+
+    // Calls visit(string_view root, string_view scheme) for each pair that
+    // produces word; returns how many there were.
+    template <class Visit> int lookup(string_view word, Visit visit) const;
+
+    uint32_t wordCount() const { return m_header ? m_header->words : 0; }
+    uint32_t stateCount() const { return m_header ? m_header->states : 0; }
+    size_t fileSize() const { return m_size; }
+
+    // Names of the roots and schemes the lexicon was compiled from.
+    uint32_t rootCount() const { return m_header ? m_header->roots : 0; }
+    uint32_t schemeCount() const { return m_header ? m_header->schemes : 0; }
+    string_view rootName(uint32_t i) const { return name(i); }
+    string_view schemeName(uint32_t i) const { return name(m_header->roots + i); }
+
+private:
+    const char*     m_base = nullptr;
+    size_t          m_size = 0;
+    bool            m_mapped = false;
+    vector<char>    m_copy;               // used when the file cannot be mapped
+
+    const header*   m_header = nullptr;
+    const state*    m_states = nullptr;
+    const uint32_t* m_edges = nullptr;    // target << 8 | label, sorted by label per state
+    const uint32_t* m_postings = nullptr; // words + 1 offsets into m_pairs
+    const uint32_t* m_pairs = nullptr;    // root, scheme
+    const uint32_t* m_names = nullptr;    // roots + schemes + 1 offsets into m_text
+    const char*     m_text = nullptr;
+
+    bool attach();
+    string_view name(uint32_t i) const { return string_view(m_text + m_names[i], m_names[i + 1] - m_names[i]); }
+};
+
+template <class Visit>
+int LexiconAutomaton::lookup(string_view word, Visit visit) const {
+    long long rank = find(word);
+    if (rank < 0) return 0;
+    uint32_t begin = m_postings[rank], end = m_postings[rank + 1];
+    for (uint32_t p = begin; p < end; p++)
+        visit(name(m_pairs[2 * p]), name(m_header->roots + m_pairs[2 * p + 1]));
+    return (int)(end - begin);
+}
@@ -1,26 +1,38 @@
-
-
+#pragma once
 using namespace std;
 #include "./Root.h"
+#include "./PackedWord.h"
 
+// Only what a descent reads lives in the Node: the packed key, the links
+// and the balance/size fields. The Root (name and derivative map) is a
+// separate record the node points at, so searches and rotations never
+// pull a derivative map into cache; the tree owns both.
 class Node {
-   Root data;
+   packed_word key;   // pack_word(data->getRoot()), PACKED_NONE if it does not pack
    Node * left;
    Node * right;
+   Root * data;
    int height;
+   int size;      // nodes in this subtree, this one included
 
 public:
  Node();
- Node(Root r);
- Node(Root r,Node* l,Node* ri);
- string getData();
+ Node(Root* r);
+ Node(Root* r,Node* l,Node* ri);
+ const string& getData() const;
+ packed_word getKey() const;
 Root& getRootObject();
+const Root& getRootObject() const;
+ Root* getRootHandle() const;
  void display();    
- Node* getLeft();
- int getHeight();
-    Node* getRight();
+ Node* getLeft() const;
+ int getHeight() const;
+ int getSize() const;
+    Node* getRight() const;
     void setLeft(Node* l);
     void setRight(Node* r);
     void setData(Root r);
+    void swapPayload(Node* other);
     void setheight(int x);
-};
\ No newline at end of file
+    void setSize(int x);
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <string_view>
+using namespace std;
+
+// Arabic words packed into one integer: each letter becomes its index in
+// the Arabic block U+0621..U+0652 (hamza forms, letters and harakat, 1..50),
+// stored 6 bits per letter from the top bit down, so up to 10 letters fit.
+// Index 0 pads the tail, which makes a shorter word sort before its
+// extensions; since the indices follow code point order, comparing two
+// packed words gives the same result as comparing their UTF-8 strings.
+// Anything outside the alphabet, malformed UTF-8 or longer than 10
+// letters packs to PACKED_NONE and stays a plain string.
+typedef unsigned long long packed_word;
+
+const packed_word PACKED_NONE     = ~0ULL;
+const int PACKED_LETTER_BITS      = 6;
+const int PACKED_MAX_LETTERS      = 10;
+const unsigned PACKED_FIRST_CP    = 0x0621;   // ء
+const unsigned PACKED_LAST_CP     = 0x0652;   // sukun
+
+packed_word pack_word(string_view utf8);
+
+// Appends letter (an alphabet index) after the first `length` letters.
+inline packed_word packed_append(packed_word w, int length, unsigned letter) {
+    return w | ((packed_word)letter << (64 - PACKED_LETTER_BITS * (length + 1)));
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+using namespace std;
+
+struct cache_stats {
+    bool enabled;
+    size_t capacity;       // entries across all shards
+    size_t entries;
+    long long hits;
+    long long misses;      // including entries left over from an older generation
+    long long evictions;
+};
+
+// Bounded cache of results keyed by a pair of strings, split into shards
+// that each have their own CLOCK hand and hash -> slot map, so an eviction
+// sweep only walks 1/16 of the entries. Every entry carries the generation
+// it was computed under; a lookup under any other generation is a miss, so
+// bumping the generation drops the whole cache at once and stale slots are
+// the first the hand reuses. Not synchronised: like the rest of the engine
+// state it is used only from the thread that owns the tree and the table.
+template <class V>
+class ResultCache {
+    static const size_t SHARDS = 16;
+
+    struct Entry {
+        string key;                 // first '\t' second
+        unsigned long long hash;
+        V value;
+        long long generation;
+        bool referenced;
+    };
+    struct Shard {
+        vector<Entry> slots;
+        unordered_map<unsigned long long, unsigned> index;
+        size_t hand = 0;
+        long long hits = 0, misses = 0, evictions = 0;
+    };
+
+    vector<unique_ptr<Shard>> m_shards;
+    size_t m_perShard;
+
+    static unsigned long long keyHash(string_view first, string_view second) {
+        return hash<string_view>()(first) * 0x9e3779b97f4a7c15ULL ^ hash<string_view>()(second);
+    }
+    static bool sameKey(const string& key, string_view first, string_view second) {
+        return key.size() == first.size() + 1 + second.size() && key.compare(0, first.size(), first) == 0
+            && key[first.size()] == '\t' && key.compare(first.size() + 1, second.size(), second) == 0;
+    }
+    Shard& shardOf(unsigned long long h) { return *m_shards[(h >> 32) % SHARDS]; }
+
+public:
+    explicit ResultCache(size_t capacity) { reset(capacity); }
+
+    // Empties the cache and sets its size; counters restart.
+    void reset(size_t capacity) {
+        m_perShard = max<size_t>(1, (capacity + SHARDS - 1) / SHARDS);
+        m_shards.clear();
+        for (size_t i = 0; i < SHARDS; i++) m_shards.emplace_back(new Shard());
+    }
+
+    bool get(string_view first, string_view second, long long generation, V& out) {
+        unsigned long long h = keyHash(first, second);
+        Shard& s = shardOf(h);
+        auto it = s.index.find(h);
+        if (it != s.index.end()) {
+            Entry& e = s.slots[it->second];
+            if (e.generation == generation && sameKey(e.key, first, second)) {
+                e.referenced = true;
+                out = e.value;
+                s.hits++;
+                return true;
+            }
+        }
+        s.misses++;
+        return false;
+    }
+
+    void put(string_view first, string_view second, long long generation, const V& value) {
+        unsigned long long h = keyHash(first, second);
+        Shard& s = shardOf(h);
+        auto it = s.index.find(h);
+        size_t slot;
+        if (it != s.index.end()) {
+            slot = it->second;
+        } else if (s.slots.size() < m_perShard) {
+            slot = s.slots.size();
+            s.slots.emplace_back();
+        } else {
+            // Second chance: referenced entries of this generation survive one pass.
+            while (s.slots[s.hand].referenced && s.slots[s.hand].generation == generation) {
+                s.slots[s.hand].referenced = false;
+                s.hand = (s.hand + 1) % s.slots.size();
+            }
+            slot = s.hand;
+            s.hand = (s.hand + 1) % s.slots.size();
+            if (s.slots[slot].generation == generation) s.evictions++;
+            s.index.erase(s.slots[slot].hash);
+        }
+        Entry& e = s.slots[slot];
+        e.key.assign(first);
+        e.key += '\t';
+        e.key.append(second);
+        e.hash = h;
+        e.value = value;
+        e.generation = generation;
+        e.referenced = false;
+        s.index[h] = (unsigned)slot;
+    }
+
+    cache_stats stats() const {
+        cache_stats out = {true, m_perShard * SHARDS, 0, 0, 0, 0};
+        for (const auto& s : m_shards) {
+            out.entries += s->slots.size();
+            out.hits += s->hits;
+            out.misses += s->misses;
+            out.evictions += s->evictions;
+        }
+        return out;
+    }
+};
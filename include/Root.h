@@ -1,20 +1,46 @@
 #pragma once
 #include <bits/stdc++.h>
+#include "./StringPool.h"
 using namespace std;
 
+// One derived word of a root: the word's id in StringPool::global() and
+// how often it was seen.
+struct derivative {
+    unsigned word;
+    int count;
+};
+
 class Root {
     string rootname;
-   unordered_map<string,int>derive;
+   vector<derivative> derive;     // sorted by word id
+   static atomic<long long> s_copies;
 public:
  Root();
  Root(string s);
-string getRoot();
-unordered_map<string, int> getDerivatives();
-int getDerivativeCount();
-int getFrequency(string derivative);
-vector<string> getDerivativesList(); 
- void addderviation(string s);
- void displayDerivatives();
-void display(); 
+ Root(const Root& other);
+ Root(Root&& other) noexcept = default;
+ Root& operator=(const Root& other);
+ Root& operator=(Root&& other) noexcept = default;
+
+const string& getRoot() const;
+const vector<derivative>& getDerivatives() const;
+int getDerivativeCount() const;
+int getFrequency(string_view derivative) const;
+vector<string> getDerivativesList() const;
+ void addderviation(string_view s, int count = 1);
+ void displayDerivatives() const;
+void display() const;
+
+ // Calls visit(string_view word, int count) for every derivative.
+ template <class Visit> void forEachDerivative(Visit visit) const {
+     const StringPool& pool = StringPool::global();
+     for (const derivative& d : derive) visit(pool.at(d.word), d.count);
+ }
+
+ // Heap bytes held by this root's derivative list (the words themselves
+ // live in the shared pool).
+ size_t derivativeBytes() const { return derive.capacity() * sizeof(derivative); }
 
-};
\ No newline at end of file
+ // Number of Root copies (name + derivative list) made so far; moves are free.
+ static long long copyCount();
+};
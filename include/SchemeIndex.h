@@ -0,0 +1,42 @@
+#pragma once
+#include "hashtable.h"
+#include <string>
+#include <vector>
+using namespace std;
+
+struct scheme_match {
+    struct node* scheme;
+    string root;
+};
+
+// Trie compiled from every scheme in a hashmap: literal letters are edges,
+// each root slot is a wildcard edge that takes exactly one letter. Matching
+// a word walks the trie once, so its cost follows the word length instead
+// of the number of schemes.
+class SchemeIndex {
+    struct TrieNode {
+        vector<pair<unsigned int, int>> next;   // literal letter -> child
+        int wildcard = -1;                      // child taking one root letter
+        vector<struct node*> schemes;           // schemes ending here
+    };
+    struct LetterSpan { int offset; int length; };
+
+    vector<TrieNode> m_nodes;
+    long long m_source = -1;                   // id of the hashmap it was built from
+    long long m_version = -1;
+
+    int child(int n, unsigned int letter) const;
+    void walk(int n, const string& word, const LetterSpan* letters, int count, int pos,
+              LetterSpan* bound, int slots, vector<scheme_match>& out) const;
+
+public:
+    static const int MAX_WORD_LETTERS = 64;
+    static const int MAX_ROOT_SLOTS   = 8;
+
+    void build(struct hashmap* hashmap_ptr);
+    bool isCurrent(const struct hashmap* hashmap_ptr) const;
+
+    // Appends every scheme that produces word, with the root letters it binds.
+    void match(const string& word, vector<scheme_match>& out) const;
+    int getNodeCount() const { return (int)m_nodes.size(); }
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+using namespace std;
+
+struct pool_stats {
+    size_t slabs;
+    size_t bytes;          // reserved by the slabs
+    size_t live;           // objects currently constructed
+    size_t free_slots;     // released slots waiting on the free list
+    size_t allocations;    // create() calls so far
+    size_t frees;          // destroy() calls so far
+};
+
+// Fixed-size object pool: objects are carved out of slabs of roughly
+// SLAB_BYTES, so neighbours in allocation order sit next to each other in
+// memory. destroy() pushes the slot onto an intrusive free list that the
+// next create() reuses; clear() destroys whatever is still live with one
+// linear sweep and hands the slabs back in a few large frees.
+template <class T>
+class SlabPool {
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static const size_t SLAB_BYTES = 64 * 1024;
+    static const size_t PER_SLAB   = SLAB_BYTES / sizeof(Slot) > 16 ? SLAB_BYTES / sizeof(Slot) : 16;
+
+    vector<Slot*> m_slabs;
+    size_t m_used = PER_SLAB;      // slots handed out from the last slab
+    Slot* m_free = nullptr;
+    size_t m_freeCount = 0;
+    size_t m_allocations = 0;
+    size_t m_frees = 0;
+
+public:
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+    ~SlabPool() { clear(); }
+
+    template <class... Args>
+    T* create(Args&&... args) {
+        Slot* slot;
+        if (m_free) {
+            slot = m_free;
+            m_free = m_free->next;
+            m_freeCount--;
+        } else {
+            if (m_used == PER_SLAB) {
+                m_slabs.push_back(static_cast<Slot*>(::operator new(PER_SLAB * sizeof(Slot))));
+                m_used = 0;
+            }
+            slot = m_slabs.back() + m_used++;
+        }
+        m_allocations++;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        if (!object) return;
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = m_free;
+        m_free = slot;
+        m_freeCount++;
+        m_frees++;
+    }
+
+    // Destroys every live object and releases all slabs.
+    void clear() {
+        vector<Slot*> freed;
+        freed.reserve(m_freeCount);
+        for (Slot* s = m_free; s; s = s->next) freed.push_back(s);
+        sort(freed.begin(), freed.end());
+
+        for (size_t i = 0; i < m_slabs.size(); i++) {
+            size_t used = i + 1 == m_slabs.size() ? m_used : PER_SLAB;
+            for (size_t k = 0; k < used; k++) {
+                Slot* s = m_slabs[i] + k;
+                if (!binary_search(freed.begin(), freed.end(), s))
+                    reinterpret_cast<T*>(s->storage)->~T();
+            }
+            ::operator delete(m_slabs[i]);
+        }
+        m_slabs.clear();
+        m_used = PER_SLAB;
+        m_free = nullptr;
+        m_freeCount = 0;
+    }
+
+    pool_stats stats() const {
+        size_t handed = m_slabs.empty() ? 0 : (m_slabs.size() - 1) * PER_SLAB + m_used;
+        return {m_slabs.size(), m_slabs.size() * PER_SLAB * sizeof(Slot),
+                handed - m_freeCount, m_freeCount, m_allocations, m_frees};
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+using namespace std;
+
+// Interns strings: each distinct string is stored once, length-prefixed,
+// in append-only 64KB blocks, and named by a dense integer id. An id maps
+// to an 8-byte block/offset reference, and lookups go through an
+// open-addressing table of ids, so a short word costs its bytes plus about
+// 16 bytes of bookkeeping. Views returned by at() stay valid for the
+// life of the pool, which is also why nothing is ever removed: the words
+// of a deleted root stay interned, so global() grows with every distinct
+// string seen since start-up, not with the live tree. Not synchronised:
+// interning happens on the thread that owns the tree, like every other
+// tree mutation.
+class StringPool {
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+
+    vector<unique_ptr<char[]>> m_blocks;
+    size_t m_blockUsed = BLOCK_BYTES;
+    vector<unsigned long long> m_refs; // id -> block << 16 | offset; no block limit
+    vector<unsigned> m_table;         // ids by hash, NONE where empty
+
+    size_t probe(string_view s, size_t h) const;
+    void grow();
+
+public:
+    static constexpr unsigned NONE = ~0u;
+
+    static StringPool& global();
+
+    unsigned intern(string_view s);
+    unsigned find(string_view s) const;            // NONE if never interned
+    string_view at(unsigned id) const;
+    size_t size() const { return m_refs.size(); }
+    size_t bytes() const;
+};
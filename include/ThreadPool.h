@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Fixed set of workers, each with its own task deque. A worker pops the
+// newest task from its own deque and, when that runs dry, steals the
+// oldest task from another worker's deque.
+class ThreadPool {
+    struct Queue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<Queue>> m_queues;
+    vector<thread> m_workers;
+
+    mutex m_sleepLock;
+    condition_variable m_wake;
+    condition_variable m_idle;
+    atomic<long long> m_queued{0};    // tasks sitting in a deque
+    atomic<long long> m_pending{0};   // tasks submitted but not finished
+    atomic<unsigned> m_nextQueue{0};
+    bool m_stop = false;
+
+    bool popLocal(unsigned worker, function<void()>& task);
+    bool steal(unsigned thief, function<void()>& task);
+    void run(unsigned worker);
+
+public:
+    explicit ThreadPool(unsigned threads = 0);   // 0 = one per hardware thread
+    ~ThreadPool();
+
+    void submit(function<void()> task);
+    void wait();
+
+    unsigned size() const { return (unsigned)m_workers.size(); }
+    static int currentWorker();                  // -1 outside the pool
+};
@@ -3,12 +3,112 @@
 #include <bits/stdc++.h>
 #include "hashtable.h"
 #include "BinarySearchTree.h"
+#include "SchemeIndex.h"
+#include "BloomFilter.h"
+#include "LexiconAutomaton.h"
+#include "DerivationMatrix.h"
+#include "ResultCache.h"
 using namespace std;
+
+const int ROOT_MAX_LETTERS = 8;
+const int WORD_BUFFER_SIZE = 128;
+
+// UTF-8 letters of a root, pointing into the caller's string.
+struct root_letters {
+    const char*   ptr[ROOT_MAX_LETTERS];
+    unsigned char len[ROOT_MAX_LETTERS];
+    unsigned short bytes[ROOT_MAX_LETTERS + 1];   // bytes[k]: length of the first k letters
+    int count;                                    // -1: more than ROOT_MAX_LETTERS
+};
+
+// Output of apply_scheme: words that fit go to buf, longer ones to spill.
+struct word_buffer {
+    char   buf[WORD_BUFFER_SIZE];
+    string spill;
+};
+
+// Counters of the Bloom pre-filter in front of validate_word.
+struct filter_stats {
+    bool enabled;
+    double fp_rate;           // target false-positive rate
+    long long words;          // (root, word) pairs in the filter
+    size_t bits;
+    int hashes;
+    long long rebuilds;
+    long long queries;        // lookups that reached the filter
+    long long rejected;       // answered NON by the filter alone
+    long long false_positives; // passed the filter, then NON from the matcher
+};
+
+// State of the materialized root x scheme matrix used by generate and
+// validate_word.
+struct matrix_stats {
+    bool enabled;
+    size_t budget;            // bytes the grid and its words may take
+    bool over_budget;         // last sync would have passed the budget
+    long long rows;
+    long long columns;
+    size_t bytes;             // grid plus its own word pool
+    long long syncs;
+    long long generated;      // cells filled so far
+    long long hits;           // answered from the grid
+    long long misses;         // generated on the fly instead
+};
+
+// Lexicon file loaded with load_lexicon(). matched: its roots and schemes
+// were those of the tree and the table at load time.
+struct lexicon_stats {
+    bool loaded;
+    bool matched;
+    long long words;
+    long long states;
+    size_t bytes;
+    long long hits;           // validate_word / analyze answered from the lexicon
+    long long misses;         // fell back: tree or table changed, or root not in it
+};
+
+// Receives each generated word; word is only valid during the call.
+typedef function<void(const string& root, const struct node* scheme, const char* word, size_t len)> word_sink;
+
 void generate(string root, struct hashmap* hashmap_ptr, BinarySearchTree* tree);
+long long generate_words(const vector<string>& roots, const vector<string>& schemes,
+                         struct hashmap* hashmap_ptr, const word_sink& sink);
+vector<pair<string, string>> generate_words(const vector<string>& roots, const vector<string>& schemes,
+                                            struct hashmap* hashmap_ptr);
+long long write_lexicon(const string& filename, struct hashmap* hashmap_ptr, BinarySearchTree* tree,
+                        unsigned threads = 0);
+long long compile_lexicon(const string& filename, struct hashmap* hashmap_ptr, BinarySearchTree* tree);
+bool load_lexicon(const string& filename, struct hashmap* hashmap_ptr, const BinarySearchTree* tree);
+long long verify_lexicon(struct hashmap* hashmap_ptr, BinarySearchTree* tree);
+const LexiconAutomaton& loaded_lexicon();
+lexicon_stats loaded_lexicon_stats();
 
 void validate(string word, string root, struct hashmap* hashmap_ptr, BinarySearchTree* tree);
 
-string apply_algo(const string& algo, const string& root);
+void split_root(const string& root, struct root_letters* letters);
+bool scheme_fits(const struct inside& scheme, const struct root_letters& letters);
+size_t apply_scheme(const struct inside& scheme, const struct root_letters& letters, char* out, size_t cap);
+string_view apply_scheme(const struct inside& scheme, const struct root_letters& letters, struct word_buffer* out);
+string apply_scheme(const struct inside& scheme, const string& root);
+const SchemeIndex& scheme_index(struct hashmap* hashmap_ptr);
+bool match_scheme(const char* word, size_t len, const struct inside& scheme, const struct root_letters& letters);
+struct node* match_scheme(const string& word, const string& root, struct hashmap* hashmap_ptr);
+// Goes through the engine's caches (lexicon, result cache, pre-filter,
+// matrix), which are not synchronised: call it, generate and the set_*
+// functions from the thread that owns the tree and the table only. Worker
+// threads use analyze(word, index, tree, out), which only reads.
+struct node* validate_word(const string& word, const string& root, struct hashmap* hashmap_ptr, const BinarySearchTree* tree);
+void set_validation_filter(bool enabled, double fp_rate);
+filter_stats validation_filter_stats();
+void set_derivation_matrix(bool enabled, size_t budget);
+matrix_stats derivation_matrix_stats();
+void set_result_cache(bool enabled, size_t capacity);
+cache_stats validation_cache_stats();
+cache_stats generation_cache_stats();
+void analyze(const string& word, struct hashmap* hashmap_ptr, BinarySearchTree* tree, vector<scheme_match>& out);
+void analyze(const string& word, const SchemeIndex& index, const BinarySearchTree& tree, vector<scheme_match>& out);
+void displayAnalysis(string word, struct hashmap* hashmap_ptr, BinarySearchTree* tree);
 void displayMorphologicalFamily(string scheme, struct hashmap* hashmap_ptr, BinarySearchTree* tree) ;
+void displayProducers(string word, struct hashmap* hashmap_ptr, BinarySearchTree* tree);
 
 #endif
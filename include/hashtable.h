@@ -1,35 +1,75 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 #include <bits/stdc++.h>
+#include "./SlabPool.h"
 using namespace std;
+const unsigned char SCHEME_LITERAL = 0xff;
+
+// One step of a compiled scheme: either copy lits[offset, offset+length)
+// or, when slot != SCHEME_LITERAL, copy root letter number `slot`.
+struct scheme_op {
+    unsigned char  slot;
+    unsigned short offset;
+    unsigned short length;
+};
+
 struct inside{
     vector<char> abst;
-    string algo;
+    string algo;                 // readable "root[N]" template, kept for display
+    string lits;
+    vector<struct scheme_op> ops;
+    int slots;                   // root letters the scheme consumes
 };
 
 struct node {
     string key;
     struct inside value;
-    node* next;
-
 };
 
+// Open-addressing table: ctrl[i] is the metadata byte of slot v[i]
+// (CTRL_EMPTY, CTRL_DELETED, or the low 7 bits of the key hash when full).
+// Slots are probed in groups of HASH_GROUP_WIDTH metadata bytes at a time.
+const signed char CTRL_EMPTY   = -128;
+const signed char CTRL_DELETED = -2;
+const int HASH_GROUP_WIDTH     = 16;
+const int HASH_INITIAL_SLOTS   = 16;
+const int HASH_MIGRATE_SLOTS   = 32;   // old slots moved per operation while growing
+
+// When the table passes 7/8 load it is replaced by a larger one and the
+// previous arrays are kept in old_ctrl/old_v; every insert/del then
+// migrates HASH_MIGRATE_SLOTS of them, so no single call pays a full rehash.
 struct hashmap {
-    long long max_element;
+    long long max_element;      // entries the current slots take before growing
     long long num_element;
+    long long num_deleted;      // tombstones in v
+    vector<signed char> ctrl;
     vector<struct node*> v;
 
+    vector<signed char> old_ctrl;
+    vector<struct node*> old_v;
+    long long old_element;      // live entries not yet migrated out of old_v
+    long long migrate_pos;
+
+    long long version;          // bumped on every insert/del, for derived indexes
+    long long id;               // unique per set_hashmap call; derived indexes key on (id, version)
+
+    SlabPool<struct node> pool; // owns every node in v and old_v
 };
 
 void setnode(struct node* node,string key,vector<char> abst,string algo);
-void set_hashmap(struct hashmap* hashmap_ptr,long long max_element);
-int hash_function(struct hashmap* hashmap_ptr, string key);
+void set_hashmap(struct hashmap* hashmap_ptr,long long max_element = HASH_INITIAL_SLOTS);
+void complete_rehash(struct hashmap* hashmap_ptr);
+unsigned long long hash_function(string_view key);
 void insert(struct hashmap* hashmap_ptr, string key);
 int search(string key,struct hashmap* hashmap_ptr);
+struct node* find_scheme(const string& key, const struct hashmap* hashmap_ptr);
+vector<struct node*> all_schemes(const struct hashmap* hashmap_ptr);
 void del (string key,struct hashmap* hashmap_ptr);
 vector<char> abst_function(string key);
 string algo_function(string key);
+void compile_scheme(const string& key, struct inside* value);
 void printAll(struct hashmap* hashmap_ptr);
+void printStats(struct hashmap* hashmap_ptr);
 void loadFromFile(struct hashmap* hashmap_ptr);
 void update(string oldKey, string newKey, struct hashmap* hashmap_ptr);
-#endif
\ No newline at end of file
+#endif
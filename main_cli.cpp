@@ -14,11 +14,16 @@
     #define WIN32_LEAN_AND_MEAN
     #include <windows.h>
 #endif
+#include <chrono>
 #include <clocale>
+#include <iomanip>
 #include <iostream>
+#include <random>
 #include <string>
+#include <unordered_set>
 
 #include "./include/core_engine.h"
+#include "./include/CorpusAnalyzer.h"
 
 using namespace std;
 
@@ -36,6 +41,50 @@ void printSeparator() {
     cout << "================================================" << endl;
 }
 
+// n distinct random 3-5 letter roots, queried 3/4 hits and 1/4 misses, against the
+// pointer AVL descent, the frozen Eytzinger array and the hash index.
+void benchmarkRootLookups() {
+    const char* letters[] = {"ب","ت","ث","ج","ح","خ","د","ذ","ر","ز","س","ش","ص","ض","ط",
+                             "ظ","ع","غ","ف","ق","ك","ل","م","ن","ه","و","ي","أ","إ","ء"};
+    const int queries = 1000000;
+    printSeparator();
+    cout << "  keys      pointer tree   frozen array   hash index   (ns / lookup)" << endl;
+    for (int n : {10000, 100000, 1000000}) {
+        mt19937 rng(n);
+        vector<string> keys;
+        unordered_set<string> seen;
+        while ((int)keys.size() < n) {
+            string r;
+            int len = 3 + rng() % 3;
+            for (int k = 0; k < len; k++) r += letters[rng() % 30];
+            if (seen.insert(r).second) keys.push_back(r);
+        }
+        BinarySearchTree bench;
+        bench.bulkLoad(keys);
+        vector<string> q;
+        for (int i = 0; i < queries; i++)
+            q.push_back(rng() % 4 ? keys[rng() % keys.size()] : "x" + to_string(i));
+
+        volatile long long found = 0;   // keeps the lookups from being optimized away
+        auto time = [&](auto lookup) {
+            long long hits = 0;
+            auto start = chrono::steady_clock::now();
+            for (const string& key : q) hits += lookup(key) != nullptr;
+            double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            found = found + hits;
+            return ns / queries;
+        };
+        double pointer = time([&](const string& k) { return bench.findOrdered(k); });
+        bench.freeze();
+        double frozen  = time([&](const string& k) { return bench.findOrdered(k); });
+        double hashed  = time([&](const string& k) { return bench.getRootNode(k); });
+        cout << "  " << setw(8) << bench.getNodeCount() << fixed << setprecision(0)
+             << setw(15) << pointer << setw(15) << frozen << setw(13) << hashed << endl;
+        cout << defaultfloat;
+    }
+    printSeparator();
+}
+
 void printMainMenu() {
     cout << "\n";
     printSeparator();
@@ -46,9 +95,14 @@ void printMainMenu() {
     cout << "  2. Search for a root" << endl;
     cout << "  3. Delete a root" << endl;
     cout << "  4. Display all roots (in-order)" << endl;
+    cout << " 22. Display roots page by page" << endl;
+    cout << " 23. Find roots by prefix" << endl;
+    cout << " 24. Find roots in a range" << endl;
+    cout << " 25. Find roots by letter pattern (e.g. ?ر?)" << endl;
     cout << "  5. Display root + its validated derivatives" << endl;
     cout << "  6. Load roots from file" << endl;
     cout << "  7. Tree statistics" << endl;
+    cout << " 21. Benchmark root lookups (10k / 100k / 1M keys)" << endl;
     cout << endl;
     cout << "--- SCHEME MANAGEMENT (Hash Table) ---" << endl;
     cout << "  8. Insert a scheme" << endl;
@@ -56,12 +110,22 @@ void printMainMenu() {
     cout << " 10. Delete a scheme" << endl;
     cout << " 11. Display all schemes" << endl;
     cout << " 12. Load schemes from file" << endl;
+    cout << " 16. Scheme table statistics" << endl;
     cout << " 17. Update a scheme" << endl;
     cout << endl;
     cout << "--- MORPHOLOGICAL ENGINE ---" << endl;
     cout << " 13. Generate word(s) from root + chosen scheme(s)" << endl;
     cout << " 14. Validate a word against a root" << endl;
      cout << " 15. Display morphological family (all roots for a scheme)" << endl;
+    cout << " 18. Analyze a word (find its root and scheme)" << endl;
+    cout << " 19. Analyze a corpus file (parallel)" << endl;
+    cout << " 20. Write full lexicon (all roots x all schemes) to file" << endl;
+    cout << " 26. Show which roots and schemes produced a stored word" << endl;
+    cout << " 27. Validation pre-filter: stats and false-positive rate" << endl;
+    cout << " 28. Compile lexicon automaton to file and load it" << endl;
+    cout << " 29. Look up a word in the lexicon automaton" << endl;
+    cout << " 30. Derivation matrix: stats and memory budget" << endl;
+    cout << " 31. Result cache: stats and capacity" << endl;
 
     cout << endl;
     cout << "  0. Exit" << endl;
@@ -75,7 +139,7 @@ int main() {
     BinarySearchTree tree;
 
     struct hashmap* hm = new struct hashmap();
-    set_hashmap(hm, 10000);
+    set_hashmap(hm);
 
     cout << "\nWelcome to the Arabic Morphological Search Engine" << endl;
     cout << "مرحباً بكم في محرك البحث المورفولوجي العربي\n" << endl;
@@ -96,7 +160,7 @@ int main() {
                 cout << "Enter root: ";
                 getline(cin, input);
                 if (input.empty()) { cout << "✗ Empty input." << endl; break; }
-                tree.insert(Root(input));
+                tree.emplace(input);
                 cout << "✓ Root \"" << input << "\" inserted." << endl;
                 break;
             }
@@ -104,7 +168,11 @@ int main() {
             case 2: {
                 cout << "Enter root to search: ";
                 getline(cin, input);
-                cout << (tree.search(input) ? "✓ Found." : "✗ Not found.") << endl;
+                if (tree.search(input))
+                    cout << "✓ Found (root " << tree.rank(input) + 1 << " of "
+                         << tree.getNodeCount() << " in order)." << endl;
+                else
+                    cout << "✗ Not found." << endl;
                 break;
             }
 
@@ -134,8 +202,9 @@ int main() {
             case 6: {
                 cout << "Enter filename: ";
                 getline(cin, input);
-                if (tree.loadRootsFromFile(input))
+                if (tree.loadRootsFromFile(input)) {
                     cout << "✓ Loaded. Tree has " << tree.getNodeCount() << " root(s)." << endl;
+                }
                 else
                     cout << "✗ Could not open \"" << input << "\"." << endl;
                 break;
@@ -146,6 +215,26 @@ int main() {
                 cout << "  Number of roots : " << tree.getNodeCount() << endl;
                 cout << "  Tree height     : " << tree.getHeight()    << endl;
                 cout << "  Empty?          : " << (tree.isEmpty() ? "Yes" : "No") << endl;
+                cout << "  Root copies made: " << Root::copyCount() << endl;
+                pool_stats ps = tree.nodeStats();
+                cout << "  Node pool       : " << ps.live << " live, " << ps.free_slots << " free, "
+                     << ps.slabs << " slab(s), " << ps.bytes / 1024 << " KB" << endl;
+                ps = tree.recordStats();
+                cout << "  Root records    : " << ps.live << " live, " << ps.free_slots << " free, "
+                     << ps.slabs << " slab(s), " << ps.bytes / 1024 << " KB" << endl;
+                long long derivs = 0;
+                size_t derivBytes = 0;
+                tree.forEach([&](const Root& r) {
+                    derivs += r.getDerivativeCount();
+                    derivBytes += r.derivativeBytes();
+                });
+                cout << "  Derivatives     : " << derivs << " (" << derivBytes / 1024 << " KB";
+                if (derivs > 0) cout << ", " << derivBytes / derivs << " B each";
+                cout << ", words in the string pool)" << endl;
+                cout << "  String pool     : " << StringPool::global().size() << " string(s), "
+                     << StringPool::global().bytes() / 1024 << " KB (shared, never shrinks)" << endl;
+                cout << "  Letter bitmaps  : " << tree.letterIndex().bitmapCount()
+                     << " (" << tree.letterIndex().bytes() / 1024 << " KB)" << endl;
                 printSeparator();
                 break;
             }
@@ -219,6 +308,10 @@ int main() {
                 displayMorphologicalFamily(input, hm, &tree);
                 break;
             }
+            case 16: {
+                printStats(hm);
+                break;
+            }
             case 17: {
                 cout << "Enter the scheme to update (old name): ";
                 getline(cin, input);
@@ -230,13 +323,213 @@ int main() {
                 break;
             }
 
+            case 18: {
+                cout << "Enter word : ";
+                getline(cin, input);
+                displayAnalysis(input, hm, &tree);
+                break;
+            }
+            case 26: {
+                cout << "Enter word : ";
+                getline(cin, input);
+                displayProducers(input, hm, &tree);
+                break;
+            }
+            case 27: {
+                filter_stats fs = validation_filter_stats();
+                printSeparator();
+                cout << "  Enabled          : " << (fs.enabled ? "Yes" : "No") << endl;
+                cout << "  Target FP rate   : " << fs.fp_rate << endl;
+                cout << "  Words / bits / k : " << fs.words << " / " << fs.bits << " / " << fs.hashes << endl;
+                cout << "  Rebuilds         : " << fs.rebuilds << endl;
+                cout << "  Queries          : " << fs.queries << endl;
+                if (fs.queries > 0) {
+                    cout << "  Rejected (NON)   : " << fs.rejected << " ("
+                         << fixed << setprecision(1) << 100.0 * fs.rejected / fs.queries << "%)" << endl;
+                    cout << "  False positives  : " << fs.false_positives << " ("
+                         << 100.0 * fs.false_positives / fs.queries << "%)" << defaultfloat << endl;
+                }
+                printSeparator();
+                cout << "New false-positive rate (0 to disable, Enter to keep): ";
+                getline(cin, input);
+                if (input.empty()) break;
+                double rate = atof(input.c_str());
+                set_validation_filter(rate > 0, rate);
+                cout << "✓ Pre-filter " << (rate > 0 ? "enabled" : "disabled") << "." << endl;
+                break;
+            }
+            case 30: {
+                matrix_stats ms = derivation_matrix_stats();
+                printSeparator();
+                cout << "  Enabled          : " << (ms.enabled ? "Yes" : "No") << endl;
+                cout << "  Budget           : " << ms.budget / 1024 << " KB"
+                     << (ms.over_budget ? "  (exceeded: generating on the fly)" : "") << endl;
+                cout << "  Rows x columns   : " << ms.rows << " x " << ms.columns << endl;
+                cout << "  Memory           : " << ms.bytes / 1024 << " KB" << endl;
+                cout << "  Syncs / cells    : " << ms.syncs << " / " << ms.generated << endl;
+                cout << "  Hits / misses    : " << ms.hits << " / " << ms.misses << endl;
+                printSeparator();
+                cout << "New budget in KB (0 to disable, Enter to keep): ";
+                getline(cin, input);
+                if (input.empty()) break;
+                long long kb = atoll(input.c_str());
+                set_derivation_matrix(kb > 0, kb > 0 ? (size_t)kb * 1024 : 0);
+                cout << "✓ Derivation matrix " << (kb > 0 ? "enabled" : "disabled") << "." << endl;
+                break;
+            }
+            case 31: {
+                cache_stats vs = validation_cache_stats(), gs = generation_cache_stats();
+                printSeparator();
+                cout << "  Enabled          : " << (vs.enabled ? "Yes" : "No") << endl;
+                for (const cache_stats* cs : {&vs, &gs}) {
+                    cout << (cs == &vs ? "  Validate (word, root)" : "  Generate (root, scheme)") << endl;
+                    cout << "    Entries        : " << cs->entries << " / " << cs->capacity << endl;
+                    cout << "    Hits / misses  : " << cs->hits << " / " << cs->misses;
+                    if (cs->hits + cs->misses > 0)
+                        cout << " (" << fixed << setprecision(1) << 100.0 * cs->hits / (cs->hits + cs->misses)
+                             << "% hits)" << defaultfloat;
+                    cout << endl;
+                    cout << "    Evictions      : " << cs->evictions << endl;
+                }
+                printSeparator();
+                cout << "New capacity in entries (0 to disable, Enter to keep): ";
+                getline(cin, input);
+                if (input.empty()) break;
+                long long entries = atoll(input.c_str());
+                set_result_cache(entries > 0, entries > 0 ? (size_t)entries : 0);
+                cout << "✓ Result cache " << (entries > 0 ? "enabled" : "disabled") << "." << endl;
+                break;
+            }
+            case 28: {
+                cout << "Enter output file path: ";
+                getline(cin, input);
+                auto start = chrono::steady_clock::now();
+                long long words = compile_lexicon(input, hm, &tree);
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (words < 0 || !load_lexicon(input, hm, &tree)) { cout << "✗ Could not write \"" << input << "\"." << endl; break; }
+                lexicon_stats ls = loaded_lexicon_stats();
+                cout << "✓ " << words << " distinct word(s), " << ls.states << " states, "
+                     << ls.bytes << " bytes, compiled in " << seconds << " s." << endl;
+                long long failed = verify_lexicon(hm, &tree);
+                if (failed == 0) cout << "✓ Every word found at its rank with its (root, scheme) pairs." << endl;
+                else cout << "✗ " << failed << " word(s) do not match the generated lexicon." << endl;
+                break;
+            }
+            case 29: {
+                if (!loaded_lexicon_stats().loaded) {
+                    cout << "Enter lexicon file path: ";
+                    getline(cin, input);
+                    if (!load_lexicon(input, hm, &tree)) { cout << "✗ \"" << input << "\" is not a lexicon file." << endl; break; }
+                }
+                lexicon_stats ls = loaded_lexicon_stats();
+                if (!ls.matched) cout << "ℹ Compiled from other roots or schemes; validation does not use it." << endl;
+                else cout << "  validate / analyze: " << ls.hits << " answered from it, " << ls.misses << " fell back" << endl;
+                cout << "Enter word : ";
+                getline(cin, input);
+                int found = loaded_lexicon().lookup(input, [](string_view root, string_view scheme) {
+                    cout << "  root " << root << "  scheme " << scheme << endl;
+                });
+                if (found == 0) cout << "✗ \"" << input << "\" is not in the lexicon." << endl;
+                else cout << "✓ " << found << " (root, scheme) pair(s)." << endl;
+                break;
+            }
+            case 19: {
+                cout << "Enter corpus file path: ";
+                getline(cin, input);
+                CorpusAnalyzer analyzer(hm, &tree);
+                corpus_report report;
+                if (!analyzer.analyzeFile(input, report)) {
+                    cout << "✗ Could not open \"" << input << "\"." << endl;
+                    break;
+                }
+                printSeparator();
+                cout << "  Threads          : " << analyzer.threadCount() << endl;
+                cout << "  Bytes read       : " << report.bytes << endl;
+                cout << "  Tokens           : " << report.tokens << endl;
+                cout << "  Analyzed tokens  : " << report.analyzed << endl;
+                cout << "  Derivations added: " << report.derivations << endl;
+                cout << "  Time             : " << report.seconds << " s ("
+                     << (report.seconds > 0 ? report.bytes / report.seconds / 1e6 : 0) << " MB/s)" << endl;
+                printSeparator();
+                break;
+            }
+            case 20: {
+                cout << "Enter output file path: ";
+                getline(cin, input);
+                auto start = chrono::steady_clock::now();
+                long long words = write_lexicon(input, hm, &tree);
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (words < 0) cout << "✗ Could not write \"" << input << "\"." << endl;
+                else cout << "✓ " << words << " word(s) written to \"" << input << "\" in "
+                          << seconds << " s." << endl;
+                break;
+            }
+            case 21: {
+                benchmarkRootLookups();
+                break;
+            }
+            case 22: {
+                int total = tree.getNodeCount();
+                if (total == 0) { cout << "Tree is empty." << endl; break; }
+                int pageSize, pageNo;
+                cout << "Roots per page: ";
+                cin >> pageSize;
+                cout << "Page number (1-" << (total + max(pageSize, 1) - 1) / max(pageSize, 1) << "): ";
+                cin >> pageNo;
+                cin.ignore();
+                if (pageSize <= 0 || pageNo <= 0) { cout << "✗ Invalid page." << endl; break; }
+                int offset = (pageNo - 1) * pageSize;
+                vector<string> roots = tree.page(offset, pageSize);
+                if (roots.empty()) { cout << "✗ No roots on that page." << endl; break; }
+                for (int i = 0; i < (int)roots.size(); i++)
+                    cout << "  " << offset + i + 1 << ". " << roots[i] << endl;
+                break;
+            }
+
+            case 23: {
+                string prefix;
+                cout << "Enter prefix: ";
+                getline(cin, prefix);
+                int total = tree.countPrefix(prefix);
+                cout << "ℹ " << total << " root(s) start with \"" << prefix << "\"" << endl;
+                int shown = tree.prefixQuery(prefix, [](const Root& r) {
+                    cout << "  " << r.getRoot() << endl;
+                }, 0, 50);
+                if (shown < total) cout << "  ... (" << total - shown << " more)" << endl;
+                break;
+            }
+
+            case 24: {
+                string lo, hi;
+                cout << "From root: ";
+                getline(cin, lo);
+                cout << "To root: ";
+                getline(cin, hi);
+                int total = tree.countRange(lo, hi);
+                cout << "ℹ " << total << " root(s) in [" << lo << ", " << hi << "]" << endl;
+                int shown = tree.rangeQuery(lo, hi, [](const Root& r) {
+                    cout << "  " << r.getRoot() << endl;
+                }, 0, 50);
+                if (shown < total) cout << "  ... (" << total - shown << " more)" << endl;
+                break;
+            }
+
+            case 25: {
+                cout << "Enter pattern, ? for any letter (e.g. ?ر?): ";
+                getline(cin, input);
+                vector<string> roots = tree.matchPattern(input);
+                cout << "ℹ " << roots.size() << " root(s) match \"" << input << "\"" << endl;
+                for (size_t i = 0; i < roots.size() && i < 50; i++) cout << "  " << roots[i] << endl;
+                if (roots.size() > 50) cout << "  ... (" << roots.size() - 50 << " more)" << endl;
+                break;
+            }
 
             case 0:
                 cout << "\nGoodbye! / وداعاً!" << endl;
                 break;
 
             default:
-                cout << "✗ Invalid option. Choose 0–14." << endl;
+                cout << "✗ Invalid option. Choose 0–31." << endl;
         }
 
     } while (choice != 0);
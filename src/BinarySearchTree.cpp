@@ -1,26 +1,24 @@
 #include "../include/BinarySearchTree.h"
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 using namespace std;
 
-BinarySearchTree::BinarySearchTree() : m_Root(nullptr) {}
-
-BinarySearchTree::~BinarySearchTree() { destroy(m_Root); }
-
-void BinarySearchTree::destroy(Node* node) {
-    if (!node) return;
-    destroy(node->getLeft());
-    destroy(node->getRight());
-    delete node;
+BinarySearchTree::BinarySearchTree() : m_Root(nullptr) {
+    static atomic<long long> nextId{0};
+    m_id = ++nextId;
 }
 
+// The pool frees every node in one sweep over its slabs.
+BinarySearchTree::~BinarySearchTree() {}
+
 Node* BinarySearchTree::rotateRight(Node* y) {
     Node* x = y->getLeft();
     Node* newleft = x->getRight();
     y->setLeft(newleft);
     x->setRight(y);
-    y->setheight(1 + max(getHeight(y->getLeft()), getHeight(y->getRight())));
-    x->setheight(1 + max(getHeight(x->getLeft()), getHeight(x->getRight())));
+    updateNode(y);
+    updateNode(x);
     return x;
 }
 
@@ -29,8 +27,8 @@ Node* BinarySearchTree::rotateLeft(Node* y) {
     Node* newRight = x->getLeft();
     y->setRight(newRight);
     x->setLeft(y);
-    y->setheight(1 + max(getHeight(y->getLeft()), getHeight(y->getRight())));
-    x->setheight(1 + max(getHeight(x->getLeft()), getHeight(x->getRight())));
+    updateNode(y);
+    updateNode(x);
     return x;
 }
 
@@ -39,26 +37,46 @@ int BinarySearchTree::getBalance(Node* y) {
     return getHeight(y->getLeft()) - getHeight(y->getRight());
 }
 
-Node* BinarySearchTree::insert(Node* node, Root r) {
-    if (!node) return new Node(r);
-    if (r.getRoot() < node->getData())
-        node->setLeft(insert(node->getLeft(), r));
-    else if (r.getRoot() > node->getData())
-        node->setRight(insert(node->getRight(), r));
+Node* BinarySearchTree::newNode(Root&& r) {
+    return m_pool.create(m_records.create(std::move(r)));
+}
+
+void BinarySearchTree::freeNode(Node* node) {
+    m_records.destroy(node->getRootHandle());
+    m_pool.destroy(node);
+}
+
+// Packed keys order like their strings, so when both sides pack the
+// comparison is a single integer compare.
+int BinarySearchTree::compareKey(string_view key, packed_word packed, const Node* node) {
+    if (packed != PACKED_NONE && node->getKey() != PACKED_NONE)
+        return packed < node->getKey() ? -1 : packed > node->getKey() ? 1 : 0;
+    return key.compare(node->getData());
+}
+
+// The key travels down as a view; the Root is built (or moved in from
+// payload) only once, at the leaf that receives it.
+Node* BinarySearchTree::insert(Node* node, string_view key, packed_word packed, Root* payload, Node*& created) {
+    if (!node) return created = newNode(payload ? std::move(*payload) : Root(string(key)));
+    int cmp = compareKey(key, packed, node);
+    if (cmp < 0)
+        node->setLeft(insert(node->getLeft(), key, packed, payload, created));
+    else if (cmp > 0)
+        node->setRight(insert(node->getRight(), key, packed, payload, created));
     else return node;
 
-    node->setheight(1 + max(getHeight(node->getLeft()), getHeight(node->getRight())));
+    updateNode(node);
     int balance = getBalance(node);
 
-    if (balance > 1 && r.getRoot() < node->getLeft()->getData())
+    if (balance > 1 && compareKey(key, packed, node->getLeft()) < 0)
         return rotateRight(node);
-    if (balance > 1 && r.getRoot() > node->getLeft()->getData()) {
+    if (balance > 1 && compareKey(key, packed, node->getLeft()) > 0) {
         node->setLeft(rotateLeft(node->getLeft()));
         return rotateRight(node);
     }
-    if (balance < -1 && r.getRoot() > node->getRight()->getData())
+    if (balance < -1 && compareKey(key, packed, node->getRight()) > 0)
         return rotateLeft(node);
-    if (balance < -1 && r.getRoot() < node->getRight()->getData()) {
+    if (balance < -1 && compareKey(key, packed, node->getRight()) < 0) {
         node->setRight(rotateRight(node->getRight()));
         return rotateLeft(node);
     }
@@ -70,23 +88,28 @@ Node* BinarySearchTree::foundMin(Node* y) {
     return y;
 }
 
-Node* BinarySearchTree::deleteN(Node* node, Root r) {
+Node* BinarySearchTree::deleteN(Node* node, string_view key, packed_word packed) {
     if (!node) return nullptr;
-    if (r.getRoot() < node->getData())
-        node->setLeft(deleteN(node->getLeft(), r));
-    else if (r.getRoot() > node->getData())
-        node->setRight(deleteN(node->getRight(), r));
+    int cmp = compareKey(key, packed, node);
+    if (cmp < 0)
+        node->setLeft(deleteN(node->getLeft(), key, packed));
+    else if (cmp > 0)
+        node->setRight(deleteN(node->getRight(), key, packed));
     else {
-        if (!node->getLeft() && !node->getRight()) { delete node; return nullptr; }
-        else if (!node->getLeft()) { Node* t = node->getRight(); delete node; return t; }
-        else if (!node->getRight()) { Node* t = node->getLeft(); delete node; return t; }
+        if (!node->getLeft() && !node->getRight()) { freeNode(node); return nullptr; }
+        else if (!node->getLeft()) { Node* t = node->getRight(); freeNode(node); return t; }
+        else if (!node->getRight()) { Node* t = node->getLeft(); freeNode(node); return t; }
         else {
+            // Swap payloads with the successor: this node keeps the successor's
+            // root and derivatives, and the doomed payload now sits in the
+            // leftmost node of the right subtree, where key still leads.
             Node* succ = foundMin(node->getRight());
-            node->setData(succ->getData());
-            node->setRight(deleteN(node->getRight(), succ->getData()));
+            node->swapPayload(succ);
+            m_index[node->getData()] = node;
+            node->setRight(deleteN(node->getRight(), key, packed));
         }
     }
-    node->setheight(1 + max(getHeight(node->getLeft()), getHeight(node->getRight())));
+    updateNode(node);
     int balance = getBalance(node);
     if (balance > 1 && getBalance(node->getLeft()) >= 0) return rotateRight(node);
     if (balance > 1 && getBalance(node->getLeft()) < 0) {
@@ -101,11 +124,14 @@ Node* BinarySearchTree::deleteN(Node* node, Root r) {
     return node;
 }
 
-Node* BinarySearchTree::search(Node* node, string value) {
-    if (!node) return nullptr;
-    if (node->getData() == value) return node;
-    else if (value < node->getData()) return search(node->getLeft(), value);
-    else return search(node->getRight(), value);
+Node* BinarySearchTree::search(Node* node, const string& value) {
+    packed_word packed = pack_word(value);
+    while (node) {
+        int cmp = compareKey(value, packed, node);
+        if (cmp == 0) return node;
+        node = cmp < 0 ? node->getLeft() : node->getRight();
+    }
+    return nullptr;
 }
 
 void BinarySearchTree::inorder(Node* node) {
@@ -122,10 +148,78 @@ void BinarySearchTree::inorder(Node* node, vector<Root>& roots) {
     inorder(node->getRight(), roots);
 }
 
-void BinarySearchTree::insert(Root r) { m_Root = insert(m_Root, r); }
-void BinarySearchTree::deleteN(Root r) { m_Root = deleteN(m_Root, r); }
-bool BinarySearchTree::search(string value) { return search(m_Root, value) != nullptr; }
-Node* BinarySearchTree::getRootNode(string value) { return search(m_Root, value); }
+// The descent compares against the key held in m_index, which stays put
+// while r's name is moved into the new node.
+void BinarySearchTree::insert(Root r) {
+    auto added = m_index.emplace(r.getRoot(), nullptr);
+    if (!added.second) return;
+    m_frozen.clear();
+    m_version++;
+    journal(true, added.first->first);
+    m_letters.add(added.first->first);
+    m_Root = insert(m_Root, added.first->first, pack_word(added.first->first), &r, added.first->second);
+}
+void BinarySearchTree::emplace(string_view rootName) {
+    auto added = m_index.emplace(string(rootName), nullptr);
+    if (!added.second) return;
+    m_frozen.clear();
+    m_version++;
+    journal(true, added.first->first);
+    m_letters.add(added.first->first);
+    m_Root = insert(m_Root, added.first->first, pack_word(added.first->first), nullptr, added.first->second);
+}
+void BinarySearchTree::deleteN(Root r) {
+    auto it = m_index.find(r.getRoot());
+    if (it == m_index.end()) return;
+    m_letters.remove(it->first);
+    m_derivations.removeRoot(it->first);
+    m_index.erase(it);
+    m_frozen.clear();
+    m_version++;
+    journal(false, r.getRoot());
+    m_Root = deleteN(m_Root, r.getRoot(), pack_word(r.getRoot()));
+}
+bool BinarySearchTree::search(const string& value) const { return m_index.count(value) != 0; }
+bool BinarySearchTree::contains(const string& value) const { return m_index.count(value) != 0; }
+Node* BinarySearchTree::getRootNode(const string& value) const {
+    auto it = m_index.find(value);
+    return it == m_index.end() ? nullptr : it->second;
+}
+bool BinarySearchTree::addDerivation(const string& root, const string& scheme, string_view word, int count) {
+    Node* node = getRootNode(root);
+    if (!node) return false;
+    node->getRootObject().addderviation(word, count);
+    m_derivations.record(root, scheme, word, count);
+    return true;
+}
+bool BinarySearchTree::addProducer(const string& root, const string& scheme, string_view word, int count) {
+    if (!contains(root)) return false;
+    m_derivations.record(root, scheme, word, count);
+    return true;
+}
+// Past the limit the older half is dropped at once, so trimming costs O(1)
+// per change on average.
+void BinarySearchTree::journal(bool added, const string& root) {
+    m_journal.push_back({m_version, added, root});
+    if (m_journal.size() <= JOURNAL_LIMIT) return;
+    m_journal.erase(m_journal.begin(), m_journal.begin() + JOURNAL_LIMIT / 2);
+    m_journalStart = m_journal.front().version - 1;
+}
+
+Node* BinarySearchTree::findOrdered(const string& value) const {
+    if (isFrozen()) return m_frozen.find(value);
+    return const_cast<BinarySearchTree*>(this)->search(m_Root, value);
+}
+
+// Lays the current keys out as a contiguous Eytzinger array for
+// findOrdered; only the lookup benchmark builds it. Any insert, delete or
+// bulk load drops it again; derivative updates do not, since the array
+// only points at the nodes.
+void BinarySearchTree::freeze() {
+    vector<Node*> nodes;
+    collectNodes(nodes);
+    m_frozen.build(nodes);
+}
 
 void BinarySearchTree::display() { inorder(m_Root); cout << endl; }
 
@@ -133,7 +227,7 @@ void BinarySearchTree::printNodeBox(Node*, const string&, bool, bool) {}
 void BinarySearchTree::displayStructured() { inorder(m_Root); cout << endl; }
 
 void BinarySearchTree::displayRootWithDerivatives(string rootName) {
-    Node* node = search(m_Root, rootName);
+    Node* node = getRootNode(rootName);
     if (!node) {
         cout << "✗ الجذر غير موجود (Root not found): " << rootName << endl;
         return;
@@ -145,19 +239,91 @@ void BinarySearchTree::displayRootWithDerivatives(string rootName) {
 bool BinarySearchTree::loadRootsFromFile(const string& filename) {
     ifstream file(filename);
     if (!file.is_open()) return false;
+    vector<string> roots;
     string line;
-    while (getline(file, line))
-        if (!line.empty()) insert(Root(line));
+    while (getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) roots.push_back(std::move(line));
+    }
     file.close();
+    bulkLoad(std::move(roots));
     return true;
 }
 
+// Every node in key order.
+void BinarySearchTree::collectNodes(vector<Node*>& nodes) const {
+    nodes.reserve(nodes.size() + m_index.size());
+    vector<Node*> stack;
+    for (Node* node = m_Root; node || !stack.empty(); node = node->getRight()) {
+        for (; node; node = node->getLeft()) stack.push_back(node);
+        node = stack.back();
+        stack.pop_back();
+        nodes.push_back(node);
+    }
+}
+
+// Links nodes[lo..hi] (already in key order) into a perfectly balanced
+// subtree and sets every height on the way back up. O(hi - lo).
+Node* BinarySearchTree::buildBalanced(vector<Node*>& nodes, int lo, int hi) {
+    if (lo > hi) return nullptr;
+    int mid = lo + (hi - lo) / 2;
+    Node* node = nodes[mid];
+    node->setLeft(buildBalanced(nodes, lo, mid - 1));
+    node->setRight(buildBalanced(nodes, mid + 1, hi));
+    updateNode(node);
+    return node;
+}
+
+// Sorts and deduplicates roots (skipping the sort if the input is already
+// ordered), merges them with the nodes already in the tree, and rebuilds
+// the whole tree bottom-up in one linear pass. Existing nodes are reused,
+// so their derivatives survive.
+void BinarySearchTree::bulkLoad(vector<string> roots) {
+    if (!is_sorted(roots.begin(), roots.end())) sort(roots.begin(), roots.end());
+    roots.erase(unique(roots.begin(), roots.end()), roots.end());
+
+    m_frozen.clear();
+    m_version++;
+    m_journal.clear();
+    m_journalStart = m_version;
+    vector<Node*> existing;
+    collectNodes(existing);
+
+    vector<Node*> merged;
+    merged.reserve(existing.size() + roots.size());
+    m_index.reserve(existing.size() + roots.size());
+    size_t i = 0;
+    for (string& key : roots) {
+        while (i < existing.size() && existing[i]->getData() < key) merged.push_back(existing[i++]);
+        if (i < existing.size() && existing[i]->getData() == key) continue;
+        Node* node = newNode(Root(std::move(key)));
+        m_letters.add(m_index.emplace(node->getData(), node).first->first);
+        merged.push_back(node);
+    }
+    while (i < existing.size()) merged.push_back(existing[i++]);
+
+    m_Root = buildBalanced(merged, 0, (int)merged.size() - 1);
+}
+
 vector<Root> BinarySearchTree::getAllRoots() {
     vector<Root> roots;
     inorder(m_Root, roots);
     return roots;
 }
 
+void BinarySearchTree::const_iterator::pushLeft(const Node* node) {
+    while (node) {
+        m_stack[m_depth++] = node;
+        node = node->getLeft();
+    }
+}
+
+BinarySearchTree::const_iterator& BinarySearchTree::const_iterator::operator++() {
+    const Node* node = m_stack[--m_depth];
+    pushLeft(node->getRight());
+    return *this;
+}
+
 int BinarySearchTree::getHeight(Node* node) {
     if (!node) return 0;
     return node->getHeight();
@@ -167,8 +333,94 @@ int BinarySearchTree::getHeight() { return getHeight(m_Root); }
 
 int BinarySearchTree::getNodeCount(Node* node) {
     if (!node) return 0;
-    return 1 + getNodeCount(node->getLeft()) + getNodeCount(node->getRight());
+    return node->getSize();
+}
+
+// Recomputes height and subtree size from the children.
+void BinarySearchTree::updateNode(Node* node) {
+    node->setheight(1 + max(getHeight(node->getLeft()), getHeight(node->getRight())));
+    node->setSize(1 + getNodeCount(node->getLeft()) + getNodeCount(node->getRight()));
+}
+
+Node* BinarySearchTree::selectNode(int k) const {
+    Node* node = m_Root;
+    while (node) {
+        int leftSize = node->getLeft() ? node->getLeft()->getSize() : 0;
+        if (k < leftSize) node = node->getLeft();
+        else if (k == leftSize) return node;
+        else {
+            k -= leftSize + 1;
+            node = node->getRight();
+        }
+    }
+    return nullptr;
+}
+
+int BinarySearchTree::rank(const string& value) const {
+    int r = 0;
+    packed_word packed = pack_word(value);
+    Node* node = m_Root;
+    while (node) {
+        if (compareKey(value, packed, node) <= 0) node = node->getLeft();
+        else {
+            r += 1 + (node->getLeft() ? node->getLeft()->getSize() : 0);
+            node = node->getRight();
+        }
+    }
+    return r;
+}
+
+BinarySearchTree::const_iterator BinarySearchTree::seek(int k) const {
+    const_iterator it;
+    const Node* node = m_Root;
+    while (node) {
+        int leftSize = node->getLeft() ? node->getLeft()->getSize() : 0;
+        if (k < leftSize) {
+            it.m_stack[it.m_depth++] = node;
+            node = node->getLeft();
+        } else if (k == leftSize) {
+            it.m_stack[it.m_depth++] = node;
+            break;
+        } else {
+            k -= leftSize + 1;
+            node = node->getRight();
+        }
+    }
+    if (!node) it.m_depth = 0;
+    return it;
+}
+
+BinarySearchTree::const_iterator BinarySearchTree::lowerBound(const string& key) const {
+    return seek(rank(key));
+}
+
+// Every key starting with prefix sorts before the prefix with its last
+// non-0xFF byte incremented, so that string's rank ends the block.
+int BinarySearchTree::prefixEndRank(const string& prefix) const {
+    string bound = prefix;
+    while (!bound.empty() && (unsigned char)bound.back() == 0xFF) bound.pop_back();
+    if (bound.empty()) return m_Root ? m_Root->getSize() : 0;
+    bound.back() = (char)((unsigned char)bound.back() + 1);
+    return rank(bound);
+}
+
+int BinarySearchTree::countRange(const string& lo, const string& hi) const {
+    if (hi < lo) return 0;
+    return rank(hi) + (contains(hi) ? 1 : 0) - rank(lo);
+}
+
+int BinarySearchTree::countPrefix(const string& prefix) const {
+    return prefixEndRank(prefix) - rank(prefix);
+}
+
+// Roots number offset .. offset+limit-1 in order.
+// One descent to the first root, then in-order steps: O(log n + limit).
+vector<string> BinarySearchTree::page(int offset, int limit) const {
+    vector<string> roots;
+    auto collect = [&](const Root& r) { roots.push_back(r.getRoot()); };
+    streamRanks(0, getNodeCount(), collect, offset, max(limit, 0));
+    return roots;
 }
 
-int BinarySearchTree::getNodeCount() { return getNodeCount(m_Root); }
+int BinarySearchTree::getNodeCount() const { return m_Root ? m_Root->getSize() : 0; }
 bool BinarySearchTree::isEmpty() { return m_Root == nullptr; }
@@ -0,0 +1,133 @@
+#include "../include/Bitmap.h"
+#include <algorithm>
+using namespace std;
+
+Bitmap::Chunk* Bitmap::findChunk(unsigned short high) {
+    auto it = lower_bound(m_chunks.begin(), m_chunks.end(), high,
+                          [](const Chunk& c, unsigned short h) { return c.high < h; });
+    return (it != m_chunks.end() && it->high == high) ? &*it : nullptr;
+}
+
+const Bitmap::Chunk* Bitmap::findChunk(unsigned short high) const {
+    return const_cast<Bitmap*>(this)->findChunk(high);
+}
+
+void Bitmap::toBitset(Chunk& c) {
+    c.bits.assign(BITSET_WORDS, 0);
+    for (unsigned short low : c.array) c.bits[low >> 6] |= 1ULL << (low & 63);
+    vector<unsigned short>().swap(c.array);
+}
+
+void Bitmap::toArray(Chunk& c) {
+    c.array.clear();
+    c.array.reserve(c.cardinality);
+    for (int w = 0; w < BITSET_WORDS; w++) {
+        unsigned long long word = c.bits[w];
+        while (word) {
+            c.array.push_back((unsigned short)(w * 64 + __builtin_ctzll(word)));
+            word &= word - 1;
+        }
+    }
+    vector<unsigned long long>().swap(c.bits);
+}
+
+void Bitmap::add(unsigned id) {
+    unsigned short high = id >> 16, low = id & 0xffff;
+    auto it = lower_bound(m_chunks.begin(), m_chunks.end(), high,
+                          [](const Chunk& c, unsigned short h) { return c.high < h; });
+    if (it == m_chunks.end() || it->high != high) it = m_chunks.insert(it, Chunk{high, 0, {}, {}});
+    Chunk& c = *it;
+
+    if (!c.bits.empty()) {
+        unsigned long long mask = 1ULL << (low & 63);
+        if (c.bits[low >> 6] & mask) return;
+        c.bits[low >> 6] |= mask;
+        c.cardinality++;
+        return;
+    }
+    auto pos = lower_bound(c.array.begin(), c.array.end(), low);
+    if (pos != c.array.end() && *pos == low) return;
+    c.array.insert(pos, low);
+    c.cardinality++;
+    if (c.cardinality > ARRAY_MAX) toBitset(c);
+}
+
+// A bitset only shrinks back to an array at half the threshold, so an id
+// toggled around ARRAY_MAX does not convert the chunk on every call.
+void Bitmap::remove(unsigned id) {
+    unsigned short high = id >> 16, low = id & 0xffff;
+    Chunk* c = findChunk(high);
+    if (!c) return;
+
+    if (!c->bits.empty()) {
+        unsigned long long mask = 1ULL << (low & 63);
+        if (!(c->bits[low >> 6] & mask)) return;
+        c->bits[low >> 6] &= ~mask;
+        c->cardinality--;
+        if (c->cardinality <= ARRAY_MAX / 2) toArray(*c);
+    } else {
+        auto pos = lower_bound(c->array.begin(), c->array.end(), low);
+        if (pos == c->array.end() || *pos != low) return;
+        c->array.erase(pos);
+        c->cardinality--;
+    }
+    if (c->cardinality == 0) m_chunks.erase(m_chunks.begin() + (c - m_chunks.data()));
+}
+
+bool Bitmap::contains(unsigned id) const {
+    const Chunk* c = findChunk(id >> 16);
+    if (!c) return false;
+    unsigned short low = id & 0xffff;
+    if (!c->bits.empty()) return (c->bits[low >> 6] >> (low & 63)) & 1;
+    return binary_search(c->array.begin(), c->array.end(), low);
+}
+
+size_t Bitmap::cardinality() const {
+    size_t n = 0;
+    for (const Chunk& c : m_chunks) n += c.cardinality;
+    return n;
+}
+
+size_t Bitmap::bytes() const {
+    size_t n = sizeof(Bitmap) + m_chunks.capacity() * sizeof(Chunk);
+    for (const Chunk& c : m_chunks)
+        n += c.array.capacity() * sizeof(unsigned short) + c.bits.capacity() * sizeof(unsigned long long);
+    return n;
+}
+
+Bitmap::Chunk Bitmap::intersect(const Chunk& a, const Chunk& b) {
+    Chunk out{a.high, 0, {}, {}};
+    if (!a.bits.empty() && !b.bits.empty()) {
+        out.bits.resize(BITSET_WORDS);
+        for (int w = 0; w < BITSET_WORDS; w++) {
+            out.bits[w] = a.bits[w] & b.bits[w];
+            out.cardinality += __builtin_popcountll(out.bits[w]);
+        }
+        if (out.cardinality <= ARRAY_MAX) toArray(out);
+    } else if (a.bits.empty() && b.bits.empty()) {
+        set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                         back_inserter(out.array));
+        out.cardinality = (int)out.array.size();
+    } else {
+        const Chunk& arr  = a.bits.empty() ? a : b;
+        const Chunk& bset = a.bits.empty() ? b : a;
+        for (unsigned short low : arr.array)
+            if ((bset.bits[low >> 6] >> (low & 63)) & 1) out.array.push_back(low);
+        out.cardinality = (int)out.array.size();
+    }
+    return out;
+}
+
+Bitmap Bitmap::intersect(const Bitmap& a, const Bitmap& b) {
+    Bitmap out;
+    size_t i = 0, j = 0;
+    while (i < a.m_chunks.size() && j < b.m_chunks.size()) {
+        if (a.m_chunks[i].high < b.m_chunks[j].high) i++;
+        else if (b.m_chunks[j].high < a.m_chunks[i].high) j++;
+        else {
+            Chunk c = intersect(a.m_chunks[i++], b.m_chunks[j++]);
+            if (c.cardinality > 0) out.m_chunks.push_back(std::move(c));
+        }
+    }
+    return out;
+}
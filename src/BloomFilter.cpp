@@ -0,0 +1,36 @@
+#include "../include/BloomFilter.h"
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+// m = -n ln p / (ln 2)^2 bits and k = (m / n) ln 2 probes; the blocks are
+// given a little extra room since blocking raises the rate slightly.
+void BloomFilter::reset(size_t expected, double fpRate) {
+    fpRate = min(max(fpRate, 1e-6), 0.5);
+    double bits = -(double)max<size_t>(expected, 1) * log(fpRate) / (log(2.0) * log(2.0)) * 1.1;
+    m_blocks = max<size_t>(1, (size_t)ceil(bits / (BLOCK_WORDS * 64)));
+    m_hashes = max(1, min(16, (int)lround(bits / max<size_t>(expected, 1) * log(2.0))));
+    m_bits.assign(m_blocks * BLOCK_WORDS, 0);
+}
+
+// The low half of the hash picks the block; the high half seeds the
+// double hashing that places the k bits inside it.
+void BloomFilter::add(unsigned long long hash) {
+    unsigned long long* block = &m_bits[(size_t)((unsigned)hash % m_blocks) * BLOCK_WORDS];
+    unsigned h1 = (unsigned)(hash >> 32), h2 = (unsigned)(hash >> 41) | 1;
+    for (int i = 0; i < m_hashes; i++) {
+        unsigned bit = (h1 + i * h2) & 511;
+        block[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+bool BloomFilter::mayContain(unsigned long long hash) const {
+    if (m_blocks == 0) return true;
+    const unsigned long long* block = &m_bits[(size_t)((unsigned)hash % m_blocks) * BLOCK_WORDS];
+    unsigned h1 = (unsigned)(hash >> 32), h2 = (unsigned)(hash >> 41) | 1;
+    for (int i = 0; i < m_hashes; i++) {
+        unsigned bit = (h1 + i * h2) & 511;
+        if (!(block[bit >> 6] >> (bit & 63) & 1)) return false;
+    }
+    return true;
+}
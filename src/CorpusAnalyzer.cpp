@@ -0,0 +1,164 @@
+#include "../include/CorpusAnalyzer.h"
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <unordered_set>
+using namespace std;
+
+CorpusAnalyzer::CorpusAnalyzer(struct hashmap* hashmap_ptr, BinarySearchTree* tree, unsigned threads)
+    : m_hashmap(hashmap_ptr), m_tree(tree), m_pool(threads) {}
+
+// Arabic letters make up tokens; harakat, tatweel and the dagger alif are
+// dropped from inside a token; anything else ends it.
+static bool is_arabic_letter(unsigned int cp) {
+    return (cp >= 0x0621 && cp <= 0x063A) || (cp >= 0x0641 && cp <= 0x064A);
+}
+
+static bool is_ignorable_mark(unsigned int cp) {
+    return (cp >= 0x064B && cp <= 0x0652) || cp == 0x0640 || cp == 0x0670;
+}
+
+// Bytes the UTF-8 character starting with lead takes; a stray continuation
+// byte counts as a character of its own.
+static size_t char_length(unsigned char lead) {
+    return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+}
+
+// Code point of a two-byte character, the only kind a token is made of;
+// 0, a separator, for anything else.
+static unsigned int code_point(const char* c, size_t len) {
+    return len == 2 ? (((unsigned char)c[0] & 0x1F) << 6) | ((unsigned char)c[1] & 0x3F) : 0;
+}
+
+// Just past the last complete separator in text[from, end): space,
+// newline, punctuation such as U+060C and U+061F, or anything else that
+// ends a token. npos if there is none.
+static size_t last_word_boundary(const string& text, size_t from) {
+    for (size_t p = text.length(); p-- > from; ) {
+        if (((unsigned char)text[p] & 0xC0) == 0x80) continue;
+        size_t len = char_length((unsigned char)text[p]);
+        if (p + len > text.length()) continue;
+        unsigned int cp = code_point(text.data() + p, len);
+        if (!is_arabic_letter(cp) && !is_ignorable_mark(cp)) return p + len;
+    }
+    return string::npos;
+}
+
+void CorpusAnalyzer::analyzeChunk(const string& chunk, const SchemeIndex& index) {
+    WorkerResult& result = m_results[ThreadPool::currentWorker()];
+
+    unordered_map<string, long long> words;
+    string token;
+    size_t i = 0;
+    while (i <= chunk.length()) {
+        unsigned int cp = 0;
+        size_t len = 1;
+        if (i < chunk.length()) {
+            len = min(char_length((unsigned char)chunk[i]), chunk.length() - i);
+            cp  = code_point(chunk.data() + i, len);
+        }
+        if (is_arabic_letter(cp)) {
+            token.append(chunk, i, len);
+        } else if (!is_ignorable_mark(cp) && !token.empty()) {
+            words[token]++;
+            token.clear();
+        }
+        i += len;
+    }
+
+    vector<scheme_match> matches;
+    for (const auto& w : words) {
+        result.tokens += w.second;
+        analyze(w.first, index, *m_tree, matches);
+        if (matches.empty()) continue;
+        result.analyzed += w.second;
+        for (const scheme_match& m : matches)
+            result.derivations[m.root + '\t' + m.scheme->key + '\t' + w.first] += w.second;
+    }
+}
+
+void CorpusAnalyzer::merge(corpus_report& report) {
+    unordered_map<string, long long> total;
+    for (WorkerResult& r : m_results) {
+        report.tokens   += r.tokens;
+        report.analyzed += r.analyzed;
+        for (auto& d : r.derivations) total[d.first] += d.second;
+    }
+    m_results.clear();
+
+    // Every scheme that yields a (root, word) pair saw the same tokens, so
+    // the root's frequency takes the count once, from the first scheme, and
+    // the others are only recorded as producers.
+    unordered_set<string> counted;
+    for (auto& d : total) {
+        size_t tab1 = d.first.find('\t');
+        size_t tab2 = d.first.find('\t', tab1 + 1);
+        string root = d.first.substr(0, tab1), scheme = d.first.substr(tab1 + 1, tab2 - tab1 - 1);
+        string_view word = string_view(d.first).substr(tab2 + 1);
+        int count = (int)min<long long>(d.second, INT_MAX);
+        if (counted.insert(root + '\t' + string(word)).second) m_tree->addDerivation(root, scheme, word, count);
+        else m_tree->addProducer(root, scheme, word, count);
+    }
+    report.derivations = (long long)counted.size();
+}
+
+bool CorpusAnalyzer::analyzeFile(const string& filename, corpus_report& report) {
+    ifstream file(filename, ios::binary);
+    if (!file.is_open()) return false;
+
+    auto start = chrono::steady_clock::now();
+    report = corpus_report();
+    m_results.assign(m_pool.size(), WorkerResult());
+    const SchemeIndex& index = scheme_index(m_hashmap);
+
+    // At most two chunks per worker are held in memory at once.
+    const unsigned maxInFlight = 2 * m_pool.size();
+    string carry;
+    vector<char> buffer(CHUNK_SIZE);
+    while (file) {
+        file.read(buffer.data(), (streamsize)buffer.size());
+        size_t got = (size_t)file.gcount();
+        if (got == 0) break;
+        report.bytes += (long long)got;
+
+        // Cut after the last separator so no word or UTF-8 letter is split.
+        // The carried text has none, except maybe a character whose tail is
+        // only now read. A window without any is carried whole, which
+        // extends the chunk to the next separator.
+        size_t carried = carry.length();
+        carry.append(buffer.data(), got);
+        size_t cut = carry.length();
+        if (file) {
+            cut = last_word_boundary(carry, carried > 3 ? carried - 3 : 0);
+            if (cut == string::npos) continue;
+        }
+        string chunk;
+        chunk.swap(carry);
+        carry.assign(chunk, cut, string::npos);
+        chunk.resize(cut);
+
+        {
+            unique_lock<mutex> lk(m_flowLock);
+            m_flow.wait(lk, [&] { return m_inFlight < maxInFlight; });
+            m_inFlight++;
+        }
+        auto shared = make_shared<string>(std::move(chunk));
+        m_pool.submit([this, shared, &index] {
+            analyzeChunk(*shared, index);
+            {
+                lock_guard<mutex> lk(m_flowLock);
+                m_inFlight--;
+            }
+            m_flow.notify_one();
+        });
+    }
+    if (!carry.empty()) {
+        auto shared = make_shared<string>(std::move(carry));
+        m_pool.submit([this, shared, &index] { analyzeChunk(*shared, index); });
+    }
+    m_pool.wait();
+    merge(report);
+
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return true;
+}
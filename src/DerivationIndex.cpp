@@ -0,0 +1,37 @@
+#include "../include/DerivationIndex.h"
+#include <algorithm>
+#include <climits>
+using namespace std;
+
+// An entry is found through the word's list, which stays short: a word is
+// rarely produced by more than a few (root, scheme) pairs. A deleted
+// root's entries are revived if the root is added back.
+void DerivationIndex::record(string_view root, string_view scheme, string_view word, int count) {
+    StringPool& pool = StringPool::global();
+    unsigned r = pool.intern(root), s = pool.intern(scheme), w = pool.intern(word);
+
+    vector<unsigned>& byWord = m_byWord[w];
+    for (unsigned e : byWord) {
+        derivation& d = m_entries[e];
+        if (d.root == r && d.scheme == s) {
+            if (d.count == 0) m_live++;
+            d.count = (int)min<long long>((long long)d.count + count, INT_MAX);
+            return;
+        }
+    }
+    unsigned e = (unsigned)m_entries.size();
+    m_entries.push_back({r, s, w, count});
+    byWord.push_back(e);
+    m_byScheme[s].push_back(e);
+    m_byRoot[r].push_back(e);
+    m_live++;
+}
+
+void DerivationIndex::removeRoot(string_view root) {
+    auto it = m_byRoot.find(StringPool::global().find(root));
+    if (it == m_byRoot.end()) return;
+    for (unsigned e : it->second) {
+        if (m_entries[e].count > 0) m_live--;
+        m_entries[e].count = 0;
+    }
+}
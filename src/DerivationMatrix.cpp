@@ -0,0 +1,114 @@
+#include "../include/DerivationMatrix.h"
+#include <algorithm>
+#include <unordered_set>
+using namespace std;
+
+long long DerivationMatrix::row(string_view root) const {
+    auto it = m_rows.find(root);
+    return it == m_rows.end() ? -1 : (long long)it->second;
+}
+
+long long DerivationMatrix::column(string_view scheme) const {
+    auto it = m_columns.find(scheme);
+    return it == m_columns.end() ? -1 : (long long)it->second;
+}
+
+void DerivationMatrix::set(size_t row, size_t column, string_view word) {
+    m_cells[row * columns() + column] = m_words.intern(word);
+    m_tags[row * columns() + column] = tag(word);
+}
+
+long long DerivationMatrix::find(size_t row, string_view word) const {
+    if (word.empty()) return -1;             // empty cells: the scheme does not fit the root
+    const unsigned* tags = m_tags.data() + row * columns();
+    const unsigned* cells = m_cells.data() + row * columns();
+    unsigned t = tag(word);
+    for (size_t c = 0; c < columns(); c++)
+        if (tags[c] == t && cells[c] != StringPool::NONE && m_words.at(cells[c]) == word) return (long long)c;
+    return -1;
+}
+
+size_t DerivationMatrix::addRow(string_view root) {
+    auto it = m_rows.find(root);
+    if (it != m_rows.end()) return it->second;
+    unsigned id = m_words.intern(root);
+    m_rows.emplace(m_words.at(id), (unsigned)rows());
+    m_rowRoots.push_back(id);
+    m_cells.resize(m_cells.size() + columns(), StringPool::NONE);
+    m_tags.resize(m_cells.size(), 0);
+    return rows() - 1;
+}
+
+void DerivationMatrix::removeRow(string_view root) {
+    auto it = m_rows.find(root);
+    if (it == m_rows.end()) return;
+    size_t r = it->second, last = rows() - 1;
+    m_rows.erase(it);
+    if (r != last) {
+        copy(m_cells.begin() + last * columns(), m_cells.begin() + (last + 1) * columns(),
+             m_cells.begin() + r * columns());
+        copy(m_tags.begin() + last * columns(), m_tags.begin() + (last + 1) * columns(),
+             m_tags.begin() + r * columns());
+        m_rowRoots[r] = m_rowRoots[last];
+        m_rows[rowRoot(r)] = (unsigned)r;
+    }
+    m_rowRoots.pop_back();
+    m_cells.resize(last * columns());
+    m_tags.resize(m_cells.size());
+}
+
+vector<size_t> DerivationMatrix::setColumns(const vector<string_view>& schemes) {
+    unordered_set<string_view> wanted(schemes.begin(), schemes.end());
+    vector<unsigned> next;
+    vector<long long> from;                      // old column of each new one, -1 if new
+    for (size_t c = 0; c < columns(); c++)
+        if (wanted.count(columnScheme(c))) {
+            next.push_back(m_columnSchemes[c]);
+            from.push_back((long long)c);
+        }
+    vector<size_t> added;
+    for (string_view s : schemes)
+        if (!m_columns.count(s)) {
+            added.push_back(next.size());
+            next.push_back(m_words.intern(s));
+            from.push_back(-1);
+        }
+    if (added.empty() && next.size() == columns()) return added;
+
+    vector<unsigned> cells(rows() * next.size(), StringPool::NONE), tags(cells.size(), 0);
+    for (size_t r = 0; r < rows(); r++)
+        for (size_t c = 0; c < next.size(); c++)
+            if (from[c] >= 0) {
+                cells[r * next.size() + c] = m_cells[r * columns() + from[c]];
+                tags[r * next.size() + c] = m_tags[r * columns() + from[c]];
+            }
+    m_cells.swap(cells);
+    m_tags.swap(tags);
+    m_columnSchemes.swap(next);
+    m_columns.clear();
+    for (size_t c = 0; c < columns(); c++) m_columns[columnScheme(c)] = (unsigned)c;
+    return added;
+}
+
+size_t DerivationMatrix::waste() const {
+    size_t live = m_cells.size() + rows() + columns();
+    return m_words.size() > live ? m_words.size() - live : 0;
+}
+
+void DerivationMatrix::clear() {
+    m_words = StringPool();
+    vector<unsigned>().swap(m_rowRoots);
+    vector<unsigned>().swap(m_columnSchemes);
+    unordered_map<string_view, unsigned>().swap(m_rows);
+    unordered_map<string_view, unsigned>().swap(m_columns);
+    vector<unsigned>().swap(m_cells);
+    vector<unsigned>().swap(m_tags);
+}
+
+// Map nodes are counted at a typical 32 bytes plus the bucket pointer.
+size_t DerivationMatrix::bytes() const {
+    return (m_cells.capacity() + m_tags.capacity() + m_rowRoots.capacity() + m_columnSchemes.capacity()) * sizeof(unsigned)
+         + (m_rows.size() + m_columns.size()) * 32
+         + (m_rows.bucket_count() + m_columns.bucket_count()) * sizeof(void*)
+         + m_words.bytes();
+}
@@ -0,0 +1,56 @@
+#include "../include/FrozenIndex.h"
+#include <cstring>
+using namespace std;
+
+unsigned long long FrozenIndex::prefixOf(string_view key) {
+    unsigned char bytes[8] = {0};
+    memcpy(bytes, key.data(), min<size_t>(8, key.size()));
+    unsigned long long p = 0;
+    for (int i = 0; i < 8; i++) p = (p << 8) | bytes[i];
+    return p;
+}
+
+// In-order walk of the implicit tree hands out the sorted nodes in turn.
+size_t FrozenIndex::fill(const vector<Node*>& sorted, size_t next, size_t k) {
+    if (k >= m_nodes.size()) return next;
+    next = fill(sorted, next, 2 * k);
+    m_nodes[k]  = sorted[next];
+    m_prefix[k] = prefixOf(sorted[next]->getData());
+    next++;
+    return fill(sorted, next, 2 * k + 1);
+}
+
+void FrozenIndex::build(const vector<Node*>& sorted) {
+    m_nodes.assign(sorted.size() + 1, nullptr);
+    m_prefix.assign(sorted.size() + 1, 0);
+    fill(sorted, 0, 1);
+}
+
+void FrozenIndex::clear() {
+    vector<unsigned long long>().swap(m_prefix);
+    vector<Node*>().swap(m_nodes);
+}
+
+bool FrozenIndex::less(size_t k, unsigned long long prefix, string_view key) const {
+    if (m_prefix[k] != prefix) return m_prefix[k] < prefix;
+    return string_view(m_nodes[k]->getData()) < key;
+}
+
+size_t FrozenIndex::lowerBound(string_view key) const {
+    size_t n = m_nodes.size();
+    unsigned long long prefix = prefixOf(key);
+    size_t k = 1;
+    while (k < n) {
+        __builtin_prefetch(&m_prefix[min(16 * k, n - 1)]);
+        k = 2 * k + (less(k, prefix, key) ? 1 : 0);
+    }
+    // Undo the trailing right turns (and the last left one) taken past the answer.
+    k >>= __builtin_ffsll(~(long long)k);
+    return k;
+}
+
+Node* FrozenIndex::find(string_view key) const {
+    size_t k = lowerBound(key);
+    if (k == 0 || m_nodes[k]->getData() != key) return nullptr;
+    return m_nodes[k];
+}
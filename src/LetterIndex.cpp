@@ -0,0 +1,92 @@
+#include "../include/LetterIndex.h"
+#include <algorithm>
+using namespace std;
+
+vector<unsigned> LetterIndex::letters(string_view s) {
+    vector<unsigned> out;
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = s[i];
+        int len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xe ? 3 : (c >> 3) == 0x1e ? 4 : 1;
+        unsigned cp = len == 1 ? c : c & (0xff >> (len + 1));
+        for (int k = 1; k < len && i + k < s.size(); k++) cp = (cp << 6) | (s[i + k] & 0x3f);
+        out.push_back(cp);
+        i += len;
+    }
+    return out;
+}
+
+void LetterIndex::add(const string& key) {
+    if (m_ids.count(key)) return;
+    unsigned id;
+    if (!m_free.empty()) {
+        id = m_free.back();
+        m_free.pop_back();
+        m_keys[id] = &key;
+    } else {
+        id = (unsigned)m_keys.size();
+        m_keys.push_back(&key);
+    }
+    m_ids.emplace(key, id);
+
+    vector<unsigned> ls = letters(key);
+    if (m_lengths.size() <= ls.size()) m_lengths.resize(ls.size() + 1);
+    m_lengths[ls.size()].add(id);
+    for (size_t p = 0; p < ls.size(); p++) m_positions[slotKey(p, ls[p])].add(id);
+}
+
+void LetterIndex::remove(const string& key) {
+    auto it = m_ids.find(key);
+    if (it == m_ids.end()) return;
+    unsigned id = it->second;
+    m_ids.erase(it);
+
+    vector<unsigned> ls = letters(key);
+    m_lengths[ls.size()].remove(id);
+    for (size_t p = 0; p < ls.size(); p++) {
+        auto bm = m_positions.find(slotKey(p, ls[p]));
+        bm->second.remove(id);
+        if (bm->second.empty()) m_positions.erase(bm);
+    }
+    m_keys[id] = nullptr;
+    m_free.push_back(id);
+}
+
+void LetterIndex::clear() {
+    m_keys.clear();
+    m_free.clear();
+    m_ids.clear();
+    m_positions.clear();
+    m_lengths.clear();
+}
+
+// Intersect the smallest bitmaps first so the running result shrinks fast.
+vector<string> LetterIndex::match(const string& pattern) const {
+    vector<string> result;
+    vector<unsigned> ls = letters(pattern);
+    if (ls.empty() || ls.size() >= m_lengths.size()) return result;
+
+    vector<const Bitmap*> sets{&m_lengths[ls.size()]};
+    for (size_t p = 0; p < ls.size(); p++) {
+        if (ls[p] == '?' || ls[p] == 0x061F) continue;
+        auto bm = m_positions.find(slotKey(p, ls[p]));
+        if (bm == m_positions.end()) return result;
+        sets.push_back(&bm->second);
+    }
+    sort(sets.begin(), sets.end(),
+         [](const Bitmap* a, const Bitmap* b) { return a->cardinality() < b->cardinality(); });
+
+    Bitmap hits = *sets[0];
+    for (size_t i = 1; i < sets.size() && !hits.empty(); i++) hits = Bitmap::intersect(hits, *sets[i]);
+
+    hits.forEach([&](unsigned id) { result.push_back(*m_keys[id]); });
+    sort(result.begin(), result.end());
+    return result;
+}
+
+size_t LetterIndex::bytes() const {
+    size_t n = m_keys.capacity() * sizeof(const string*) + m_free.capacity() * sizeof(unsigned)
+             + m_ids.size() * (sizeof(string_view) + sizeof(unsigned) + sizeof(void*));
+    for (const auto& p : m_positions) n += sizeof(p.first) + p.second.bytes();
+    for (const Bitmap& b : m_lengths) n += b.bytes();
+    return n;
+}
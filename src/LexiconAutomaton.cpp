@@ -0,0 +1,292 @@
+#include "../include/LexiconAutomaton.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+static const char LEXICON_MAGIC[8] = {'A', 'M', 'L', 'E', 'X', '0', '1', '\0'};
+static const uint32_t MAX_STATES = 1u << 24;          // edges keep the target in 24 bits
+
+// Incremental construction of the minimal automaton from sorted words
+// (Daciuk et al.): only the path of the previous word is still open, and
+// when the next word leaves it, the states below the split are replaced
+// by an equivalent registered state or registered themselves.
+namespace {
+struct BuildState {
+    vector<pair<uint8_t, uint32_t>> edges;
+    bool final = false;
+};
+
+struct AutomatonBuilder {
+    vector<BuildState> states = vector<BuildState>(1);
+    vector<uint32_t> freed;
+    unordered_map<string, uint32_t> registry;
+    vector<uint32_t> path{0};
+
+    string signature(uint32_t s) const {
+        string key(1, states[s].final ? '1' : '0');
+        for (const auto& e : states[s].edges) {
+            key += (char)e.first;
+            key.append((const char*)&e.second, sizeof e.second);
+        }
+        return key;
+    }
+
+    uint32_t newState() {
+        if (freed.empty()) {
+            states.emplace_back();
+            return (uint32_t)states.size() - 1;
+        }
+        uint32_t s = freed.back();
+        freed.pop_back();
+        return s;
+    }
+
+    void minimize(size_t depth) {
+        while (path.size() > depth + 1) {
+            uint32_t child = path.back();
+            path.pop_back();
+            auto found = registry.emplace(signature(child), child);
+            if (!found.second) {
+                states[path.back()].edges.back().second = found.first->second;
+                states[child] = BuildState();
+                freed.push_back(child);
+            }
+        }
+    }
+
+    void add(string_view word, size_t common) {
+        minimize(common);
+        for (size_t i = common; i < word.size(); i++) {
+            uint32_t s = newState();
+            states[path.back()].edges.push_back({(uint8_t)word[i], s});
+            path.push_back(s);
+        }
+        states[path.back()].final = true;
+    }
+
+    uint32_t count(uint32_t s, vector<uint32_t>& counts) const {
+        if (counts[s] != UINT32_MAX) return counts[s];
+        uint32_t n = states[s].final ? 1 : 0;
+        for (const auto& e : states[s].edges) n += count(e.second, counts);
+        return counts[s] = n;
+    }
+};
+
+template <class T>
+void append_raw(string& out, const T* data, size_t n) {
+    out.append((const char*)data, n * sizeof(T));
+}
+}
+
+long long LexiconAutomaton::write(const string& filename, const vector<string>& roots, const vector<string>& schemes,
+                                  const string& text, vector<lexicon_word>& words) {
+    auto wordOf = [&](const lexicon_word& w) { return string_view(text).substr(w.offset, w.length); };
+    sort(words.begin(), words.end(), [&](const lexicon_word& a, const lexicon_word& b) {
+        int c = wordOf(a).compare(wordOf(b));
+        if (c != 0) return c < 0;
+        return a.root != b.root ? a.root < b.root : a.scheme < b.scheme;
+    });
+
+    // Distinct words feed the automaton; their (root, scheme) pairs are
+    // grouped under the word's rank.
+    AutomatonBuilder builder;
+    vector<uint32_t> postings{0};
+    vector<uint32_t> pairs;
+    string_view previous;
+    for (size_t i = 0; i < words.size(); i++) {
+        string_view word = wordOf(words[i]);
+        if (i == 0 || word != previous) {
+            size_t common = 0;
+            while (i > 0 && common < word.size() && common < previous.size() && word[common] == previous[common]) common++;
+            builder.add(word, common);
+            if (i > 0) postings.push_back((uint32_t)(pairs.size() / 2));
+            previous = word;
+        } else if (words[i].root == words[i - 1].root && words[i].scheme == words[i - 1].scheme) {
+            continue;
+        }
+        pairs.push_back(words[i].root);
+        pairs.push_back(words[i].scheme);
+    }
+    builder.minimize(0);
+    if (!words.empty()) postings.push_back((uint32_t)(pairs.size() / 2));
+    uint32_t wordCount = (uint32_t)postings.size() - 1;
+
+    // Renumber the reachable states breadth-first, so a walk moves forward
+    // through the file.
+    vector<uint32_t> counts(builder.states.size(), UINT32_MAX);
+    builder.count(0, counts);
+    vector<uint32_t> order{0};
+    vector<uint32_t> number(builder.states.size(), UINT32_MAX);
+    number[0] = 0;
+    for (size_t i = 0; i < order.size(); i++)
+        for (const auto& e : builder.states[order[i]].edges)
+            if (number[e.second] == UINT32_MAX) {
+                number[e.second] = (uint32_t)order.size();
+                order.push_back(e.second);
+            }
+    if (order.size() >= MAX_STATES) return -1;
+
+    vector<state> states;
+    vector<uint32_t> edges;
+    for (uint32_t s : order) {
+        const BuildState& b = builder.states[s];
+        states.push_back({(uint32_t)edges.size(), counts[s], (uint16_t)b.edges.size(), (uint8_t)b.final, 0});
+        for (const auto& e : b.edges) edges.push_back(number[e.second] << 8 | e.first);
+    }
+
+    vector<uint32_t> names{0};
+    string nameText;
+    for (const string& r : roots)   { nameText += r; names.push_back((uint32_t)nameText.size()); }
+    for (const string& s : schemes) { nameText += s; names.push_back((uint32_t)nameText.size()); }
+
+    header h;
+    memcpy(h.magic, LEXICON_MAGIC, sizeof h.magic);
+    h.states = (uint32_t)states.size();
+    h.edges = (uint32_t)edges.size();
+    h.words = wordCount;
+    h.pairs = (uint32_t)(pairs.size() / 2);
+    h.roots = (uint32_t)roots.size();
+    h.schemes = (uint32_t)schemes.size();
+    h.text = (uint32_t)nameText.size();
+    h.reserved = 0;
+
+    string out;
+    append_raw(out, &h, 1);
+    append_raw(out, states.data(), states.size());
+    append_raw(out, edges.data(), edges.size());
+    append_raw(out, postings.data(), postings.size());
+    append_raw(out, pairs.data(), pairs.size());
+    append_raw(out, names.data(), names.size());
+    out += nameText;
+
+    // Written beside the target and renamed over it, so readers see the
+    // old file or the new one, never a partial image.
+    string temp = filename + ".tmp";
+    ofstream file(temp, ios::binary);
+    if (!file.is_open()) return -1;
+    file.write(out.data(), (streamsize)out.size());
+    file.flush();
+    file.close();
+    if (!file) {
+        remove(temp.c_str());
+        return -1;
+    }
+#ifdef _WIN32
+    remove(filename.c_str());
+#endif
+    if (rename(temp.c_str(), filename.c_str()) != 0) {
+        remove(temp.c_str());
+        return -1;
+    }
+    return (long long)wordCount;
+}
+
+bool LexiconAutomaton::open(const string& filename) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                m_base = (const char*)p;
+                m_size = (size_t)st.st_size;
+                m_mapped = true;
+            }
+        }
+        ::close(fd);
+    }
+#endif
+    if (!m_base) {
+        ifstream file(filename, ios::binary);
+        if (!file.is_open()) return false;
+        m_copy.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        m_base = m_copy.data();
+        m_size = m_copy.size();
+    }
+    if (attach()) return true;
+    close();
+    return false;
+}
+
+void LexiconAutomaton::close() {
+#ifndef _WIN32
+    if (m_mapped) munmap((void*)m_base, m_size);
+#endif
+    vector<char>().swap(m_copy);
+    m_base = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_header = nullptr;
+}
+
+// Points the section pointers into the image after checking that the
+// header's counts fit the file and that every edge, posting, pair and name
+// offset stays inside its section, so lookups never read past the image.
+bool LexiconAutomaton::attach() {
+    if (m_size < sizeof(header)) return false;
+    m_header = (const header*)m_base;
+    if (memcmp(m_header->magic, LEXICON_MAGIC, sizeof LEXICON_MAGIC) != 0) return false;
+
+    const header& h = *m_header;
+    size_t need = sizeof(header) + (size_t)h.states * sizeof(state)
+                + ((size_t)h.edges + h.words + 1 + 2 * (size_t)h.pairs + h.roots + h.schemes + 1) * 4 + h.text;
+    if (h.states == 0 || need != m_size) return false;
+
+    const char* p = m_base + sizeof(header);
+    m_states   = (const state*)p;    p += (size_t)h.states * sizeof(state);
+    m_edges    = (const uint32_t*)p; p += (size_t)h.edges * 4;
+    m_postings = (const uint32_t*)p; p += ((size_t)h.words + 1) * 4;
+    m_pairs    = (const uint32_t*)p; p += (size_t)h.pairs * 8;
+    m_names    = (const uint32_t*)p; p += ((size_t)h.roots + h.schemes + 1) * 4;
+    m_text     = p;
+
+    if (m_states[0].count != h.words) return false;
+    for (uint32_t s = 0; s < h.states; s++) {
+        const state& st = m_states[s];
+        if ((uint64_t)st.first_edge + st.edge_count > h.edges) return false;
+        for (uint32_t e = st.first_edge; e < st.first_edge + st.edge_count; e++) {
+            if ((m_edges[e] >> 8) >= h.states) return false;
+            if (e > st.first_edge && (m_edges[e] & 0xff) <= (m_edges[e - 1] & 0xff)) return false;
+        }
+    }
+    if (m_postings[0] != 0 || m_postings[h.words] != h.pairs) return false;
+    for (uint32_t w = 0; w < h.words; w++)
+        if (m_postings[w] > m_postings[w + 1]) return false;
+    for (uint32_t i = 0; i < h.pairs; i++)
+        if (m_pairs[2 * i] >= h.roots || m_pairs[2 * i + 1] >= h.schemes) return false;
+    if (m_names[0] != 0 || m_names[h.roots + h.schemes] != h.text) return false;
+    for (uint32_t i = 0; i < h.roots + h.schemes; i++)
+        if (m_names[i] > m_names[i + 1]) return false;
+    return true;
+}
+
+// Each step adds the words that end at the current state and those below
+// the smaller edge labels, which is the word's position in sorted order.
+long long LexiconAutomaton::find(string_view word) const {
+    if (!m_header) return -1;
+    uint32_t s = 0;
+    long long rank = 0;
+    for (unsigned char c : word) {
+        const state& st = m_states[s];
+        if (st.final) rank++;
+        const uint32_t* e = m_edges + st.first_edge;
+        const uint32_t* end = e + st.edge_count;
+        while (e != end && (*e & 0xff) < c) rank += m_states[*e++ >> 8].count;
+        if (e == end || (*e & 0xff) != c) return -1;
+        s = *e >> 8;
+    }
+    // The counts are not checked against each other on open, so a damaged
+    // file could still give a rank past the postings.
+    return m_states[s].final && rank < m_header->words ? rank : -1;
+}
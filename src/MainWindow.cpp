@@ -15,7 +15,7 @@
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     m_tree    = new BinarySearchTree();
     m_hashmap = new struct hashmap();
-    set_hashmap(m_hashmap, 10000);
+    set_hashmap(m_hashmap);
 
     setupStyleSheet();
     setupUI();
@@ -548,7 +548,7 @@ void MainWindow::setupSchemeTab() {
     QGroupBox* tableGroup = new QGroupBox("Scheme Database  (قاعدة الأوزان)");
     QVBoxLayout* tableLayout = new QVBoxLayout(tableGroup);
     m_schemeTable = new QTableWidget(0, 3);
-    m_schemeTable->setHorizontalHeaderLabels({"Bucket", "Scheme  (الوزن)", "Algorithm  (الخوارزمية)"});
+    m_schemeTable->setHorizontalHeaderLabels({"Slot", "Scheme  (الوزن)", "Algorithm  (الخوارزمية)"});
     m_schemeTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
     m_schemeTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
     m_schemeTable->setColumnWidth(0, 60);
@@ -735,7 +735,7 @@ void MainWindow::setupAboutTab() {
         "<div style='line-height:2; color:#c9d1d9; font-size:13px;'>"
         "<b style='color:#58a6ff;'>Data Structures:</b><br>"
         "&nbsp;&nbsp;• <b>AVL Tree</b> (BinarySearchTree) — stores and balances Arabic roots with O(log n) operations<br>"
-        "&nbsp;&nbsp;• <b>Hash Table</b> (hashmap) — stores morphological schemes with chaining collision resolution<br><br>"
+        "&nbsp;&nbsp;• <b>Hash Table</b> (hashmap) — stores morphological schemes with open addressing (16-slot group probing)<br><br>"
         "<b style='color:#58a6ff;'>Features:</b><br>"
         "&nbsp;&nbsp;• Insert / Search / Delete Arabic roots (AVL auto-balancing)<br>"
         "&nbsp;&nbsp;• Insert / Search / Delete / Update morphological schemes<br>"
@@ -803,28 +803,23 @@ void MainWindow::refreshTreeView() {
 
 void MainWindow::refreshSchemeTable() {
     m_schemeTable->setRowCount(0);
-    for (int i = 0; i < (int)m_hashmap->v.size(); i++) {
-        struct node* cur = m_hashmap->v[i];
-        while (cur) {
-            int row = m_schemeTable->rowCount();
-            m_schemeTable->insertRow(row);
-            auto* bucketItem = new QTableWidgetItem(QString::number(i));
-            bucketItem->setTextAlignment(Qt::AlignCenter);
-            bucketItem->setForeground(QColor(88, 166, 255));
-            m_schemeTable->setItem(row, 0, bucketItem);
-
-            auto* keyItem = new QTableWidgetItem(QString::fromStdString(cur->key));
-            keyItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-            keyItem->setFont(QFont("Arial", 13));
-            m_schemeTable->setItem(row, 1, keyItem);
-
-            auto* algoItem = new QTableWidgetItem(QString::fromStdString(cur->value.algo));
-            algoItem->setFont(QFont("Courier New", 11));
-            algoItem->setForeground(QColor(121, 192, 255));
-            m_schemeTable->setItem(row, 2, algoItem);
-
-            cur = cur->next;
-        }
+    for (struct node* cur : all_schemes(m_hashmap)) {
+        int row = m_schemeTable->rowCount();
+        m_schemeTable->insertRow(row);
+        auto* bucketItem = new QTableWidgetItem(QString::number(search(cur->key, m_hashmap)));
+        bucketItem->setTextAlignment(Qt::AlignCenter);
+        bucketItem->setForeground(QColor(88, 166, 255));
+        m_schemeTable->setItem(row, 0, bucketItem);
+
+        auto* keyItem = new QTableWidgetItem(QString::fromStdString(cur->key));
+        keyItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        keyItem->setFont(QFont("Arial", 13));
+        m_schemeTable->setItem(row, 1, keyItem);
+
+        auto* algoItem = new QTableWidgetItem(QString::fromStdString(cur->value.algo));
+        algoItem->setFont(QFont("Courier New", 11));
+        algoItem->setForeground(QColor(121, 192, 255));
+        m_schemeTable->setItem(row, 2, algoItem);
     }
 }
 
@@ -835,7 +830,7 @@ void MainWindow::refreshSchemeTable() {
 void MainWindow::onInsertRoot() {
     QString input = m_rootInput->text().trimmed();
     if (input.isEmpty()) { logError("Empty input — please enter a root."); return; }
-    m_tree->insert(Root(input.toStdString()));
+    m_tree->emplace(input.toStdString());
     logSuccess(QString("Root \"%1\" inserted into AVL tree.").arg(input));
     m_rootInput->clear();
     refreshTreeView();
@@ -871,10 +866,9 @@ void MainWindow::onDeleteRoot() {
 
 void MainWindow::onDisplayAllRoots() {
     if (m_tree->isEmpty()) { logInfo("Tree is empty."); return; }
-    vector<Root> roots = m_tree->getAllRoots();
-    logInfo(QString("All %1 root(s) in order:").arg(roots.size()));
     QStringList parts;
-    for (auto& r : roots) parts << QString::fromStdString(r.getRoot());
+    for (const Root& r : *m_tree) parts << QString::fromStdString(r.getRoot());
+    logInfo(QString("All %1 root(s) in order:").arg(parts.size()));
     log("  " + parts.join("  →  "), "#c9d1d9");
 }
 
@@ -893,22 +887,23 @@ void MainWindow::onTreeNodeClicked(const QString& rootName) {
     Node* nd = m_tree->getRootNode(rootName.toStdString());
     if (!nd) return;
 
-    auto derivs = nd->getRootObject().getDerivatives();
+    const auto& derivs = nd->getRootObject().getDerivatives();
     if (derivs.empty()) {
         m_derivativesList->addItem("(No derivatives yet)");
         logInfo(QString("Root \"%1\" has no derivatives yet.").arg(rootName));
     } else {
-        for (auto& [word, freq] : derivs) {
+        nd->getRootObject().forEachDerivative([&](string_view word, int freq) {
             auto* item = new QListWidgetItem(
-                QString("%1   (freq: %2)").arg(QString::fromStdString(word)).arg(freq));
+                QString("%1   (freq: %2)").arg(QString::fromUtf8(word.data(), (int)word.size())).arg(freq));
             item->setTextAlignment(Qt::AlignRight);
             m_derivativesList->addItem(item);
-        }
+        });
         logInfo(QString("Root \"%1\" — %2 derivative(s):")
                     .arg(rootName).arg(derivs.size()));
-        for (auto& [word, freq] : derivs)
-            log(QString("  • %1  (×%2)").arg(QString::fromStdString(word)).arg(freq),
+        nd->getRootObject().forEachDerivative([&](string_view word, int freq) {
+            log(QString("  • %1  (×%2)").arg(QString::fromUtf8(word.data(), (int)word.size())).arg(freq),
                 "#79c0ff");
+        });
     }
 }
 
@@ -944,7 +939,7 @@ void MainWindow::onSearchScheme() {
     if (input.isEmpty()) { logError("Enter a scheme to search."); return; }
     int pos = search(input.toStdString(), m_hashmap);
     if (pos != -1)
-        logSuccess(QString("Scheme \"%1\" found in bucket %2.").arg(input).arg(pos));
+        logSuccess(QString("Scheme \"%1\" found in slot %2.").arg(input).arg(pos));
     else
         logError(QString("Scheme \"%1\" not found.").arg(input));
 }
@@ -1016,19 +1011,18 @@ void MainWindow::onGenerateWord() {
     }
 
     // Find scheme algo in hashmap
-    int pos = search(scheme.toStdString(), m_hashmap);
-    if (pos == -1) {
+    struct node* cur = find_scheme(scheme.toStdString(), m_hashmap);
+    if (cur == NULL) {
         m_engineLog->append(QString("<span style='color:#f85149;'>✗ Scheme \"%1\" not found in hash table.</span>").arg(scheme));
         return;
     }
-    struct node* cur = m_hashmap->v[pos];
-    while (cur && cur->key != scheme.toStdString()) cur = cur->next;
-    if (!cur) {
-        m_engineLog->append("<span style='color:#f85149;'>✗ Scheme not found.</span>");
+
+    string word = apply_scheme(cur->value, root.toStdString());
+    if (word.empty()) {
+        m_engineLog->append(QString("<span style='color:#f85149;'>✗ Scheme \"%1\" takes %2 root letters; \"%3\" does not fit it.</span>")
+                                .arg(scheme).arg(cur->value.slots).arg(root));
         return;
     }
-
-    string word = apply_algo(cur->value.algo, root.toStdString());
     QString qword = QString::fromStdString(word);
 
     m_engineLog->append(QString(
@@ -1040,9 +1034,7 @@ void MainWindow::onGenerateWord() {
                             "</div>").arg(root).arg(scheme).arg(qword));
 
 
-    Node* nd = m_tree->getRootNode(root.toStdString());
-    if (nd) {
-        nd->getRootObject().addderviation(word);
+    if (m_tree->addDerivation(root.toStdString(), scheme.toStdString(), word)) {
         m_engineLog->append(QString("<span style='color:#2ea043;'>✓ \"%1\" stored as derivative of \"%2\" in AVL tree.</span>")
                                 .arg(qword).arg(root));
         refreshTreeView();
@@ -1061,20 +1053,9 @@ void MainWindow::onValidateWord() {
         return;
     }
 
-    // Inline validate: search all schemes for a match
     string result = "NON";
-    for (int i = 0; i < (int)m_hashmap->v.size(); i++) {
-        struct node* cn = m_hashmap->v[i];
-        while (cn) {
-            string generated = apply_algo(cn->value.algo, root.toStdString());
-            if (generated == word.toStdString()) {
-                result = "OUI|" + cn->key;
-                break;
-            }
-            cn = cn->next;
-        }
-        if (result != "NON") break;
-    }
+    struct node* matched = validate_word(word.toStdString(), root.toStdString(), m_hashmap, m_tree);
+    if (matched) result = "OUI|" + matched->key;
     QString qresult = QString::fromStdString(result);
 
     if (qresult.startsWith("OUI|")) {
@@ -1086,9 +1067,7 @@ void MainWindow::onValidateWord() {
                                 "</div>").arg(word).arg(matchedScheme).arg(root));
 
         // Store in AVL tree
-        Node* nd = m_tree->getRootNode(root.toStdString());
-        if (nd) {
-            nd->getRootObject().addderviation(word.toStdString());
+        if (m_tree->addDerivation(root.toStdString(), matched->key, word.toStdString())) {
             m_engineLog->append(QString("<span style='color:#2ea043;'>✓ \"%1\" stored as derivative of \"%2\".</span>")
                                     .arg(word).arg(root));
             refreshTreeView();
@@ -1111,22 +1090,12 @@ void MainWindow::onMorphologicalFamily() {
 
     // Inline morphological family
     vector<pair<string,string>> results;
-    {
-        int pos = search(scheme.toStdString(), m_hashmap);
-        if (pos != -1) {
-            struct node* sn = m_hashmap->v[pos];
-            while (sn && sn->key != scheme.toStdString()) sn = sn->next;
-            if (sn) {
-                string algo = sn->value.algo;
-                vector<Root> allRoots = m_tree->getAllRoots();
-                for (Root& r : allRoots) {
-                    string expectedWord = apply_algo(algo, r.getRoot());
-                    auto derivs = r.getDerivatives();
-                    if (derivs.count(expectedWord))
-                        results.push_back({r.getRoot(), expectedWord});
-                }
-            }
-        }
+    if (search(scheme.toStdString(), m_hashmap) != -1) {
+        const StringPool& pool = StringPool::global();
+        m_tree->derivations().forScheme(scheme.toStdString(), [&](const derivation& d) {
+            results.push_back({string(pool.at(d.root)), string(pool.at(d.word))});
+        });
+        sort(results.begin(), results.end());
     }
 
     m_engineLog->append(QString(
@@ -1,41 +1,54 @@
-
 using namespace std;
 #include"../include/Node.h"
 
-Node::Node(){
+Node::Node() : key(0), left(NULL), right(NULL), data(NULL), height(1), size(1) {
 };
-Node::Node(Root r){
-   data=r;
+Node::Node(Root* r) : key(pack_word(r->getRoot())), data(r) {
     left=NULL;
     right=NULL;
     height=1;
+    size=1;
 };
-Node::Node(Root r,Node* l,Node* ri){
-      data=r;
+Node::Node(Root* r,Node* l,Node* ri) : key(pack_word(r->getRoot())), data(r) {
     left=l;
     right=ri;
     height=1;
+    size=1;
 };
-string Node::getData(){
-    return data.getRoot();
+const string& Node::getData() const {
+    return data->getRoot();
 };
-Node* Node::getLeft() { return left; };
-Node* Node::getRight() { return right; };
-int Node::getHeight() { return height; };
+packed_word Node::getKey() const { return key; };
+Node* Node::getLeft() const { return left; };
+Node* Node::getRight() const { return right; };
+int Node::getHeight() const { return height; };
+int Node::getSize() const { return size; };
 void Node::setLeft(Node* l) { left = l; };
 void Node::setRight(Node* r) { right = r; };
 void Node::setheight(int x) { height= x; };
+void Node::setSize(int x) { size = x; };
 Root& Node::getRootObject() {
+    return *data;
+}
+const Root& Node::getRootObject() const {
+    return *data;
+}
+Root* Node::getRootHandle() const {
     return data;
 }
 void Node::setData(Root r) {
-    data = r;
+    *data = std::move(r);
+    key = pack_word(data->getRoot());
+}
+void Node::swapPayload(Node* other) {
+    swap(data, other->data);
+    swap(key, other->key);
 }
 
 void Node::display() {
-    cout << "الجذر (Root): " << data.getRoot() <<" ";
+    cout << "الجذر (Root): " << data->getRoot() <<" ";
     cout<<height<<endl;
-    data.displayDerivatives();
+    data->displayDerivatives();
     cout << "----------------" << endl;
 
     if(left != nullptr) left->display();
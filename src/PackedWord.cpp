@@ -0,0 +1,18 @@
+#include "../include/PackedWord.h"
+using namespace std;
+
+packed_word pack_word(string_view utf8) {
+    packed_word w = 0;
+    int length = 0;
+    for (size_t i = 0; i < utf8.size(); i += 2) {
+        unsigned char lead = utf8[i];
+        if ((lead >> 5) != 0x6 || lead < 0xC2 || i + 1 >= utf8.size()) return PACKED_NONE;
+        unsigned char next = utf8[i + 1];
+        // Malformed pairs must not pack: two of them could share a value.
+        if ((next & 0xC0) != 0x80) return PACKED_NONE;
+        unsigned cp = ((lead & 0x1f) << 6) | (next & 0x3f);
+        if (cp < PACKED_FIRST_CP || cp > PACKED_LAST_CP || length == PACKED_MAX_LETTERS) return PACKED_NONE;
+        w = packed_append(w, length++, cp - PACKED_FIRST_CP + 1);
+    }
+    return w;
+}
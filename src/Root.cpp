@@ -2,49 +2,65 @@
 
 using namespace std;
  
+atomic<long long> Root::s_copies{0};
+
 Root::Root(){}
-Root::Root(string s){
-    rootname=s;
+Root::Root(string s) : rootname(std::move(s)) {}
+Root::Root(const Root& other) : rootname(other.rootname), derive(other.derive) {
+    s_copies++;
+}
+Root& Root::operator=(const Root& other) {
+    rootname = other.rootname;
+    derive   = other.derive;
+    s_copies++;
+    return *this;
 }
- string Root::getRoot(){
+long long Root::copyCount() { return s_copies.load(); }
+
+ const string& Root::getRoot() const {
     return rootname;
  }
-unordered_map<string, int> Root::getDerivatives() {
+const vector<derivative>& Root::getDerivatives() const {
     return derive;
 }
 
-int Root::getDerivativeCount() {
+int Root::getDerivativeCount() const {
     return derive.size();
 }
-int Root::getFrequency(string derivative) {
-    if(derive[derivative]) {
-        return derive[derivative];
-    }
-    return 0;
+
+static bool byWord(const derivative& d, unsigned word) { return d.word < word; }
+
+// Looks the word up without interning it, so a miss changes nothing.
+int Root::getFrequency(string_view word) const {
+    unsigned id = StringPool::global().find(word);
+    if (id == StringPool::NONE) return 0;
+    auto it = lower_bound(derive.begin(), derive.end(), id, byWord);
+    return (it != derive.end() && it->word == id) ? it->count : 0;
 }
-vector<string> Root::getDerivativesList() {
+vector<string> Root::getDerivativesList() const {
     vector<string> list;
-    for(auto pair : derive) {
-        list.push_back(pair.first);
-    }
+    forEachDerivative([&](string_view word, int) { list.emplace_back(word); });
     return list;
 }
- void Root::addderviation(string s){ 
-    derive[s]++;
+ void Root::addderviation(string_view s, int count){ 
+    unsigned id = StringPool::global().intern(s);
+    auto it = lower_bound(derive.begin(), derive.end(), id, byWord);
+    if (it != derive.end() && it->word == id) it->count = (int)min<long long>((long long)it->count + count, INT_MAX);
+    else derive.insert(it, derivative{id, count});
  }
 
-void Root::displayDerivatives() {
+void Root::displayDerivatives() const {
     if(derive.empty()) {
         cout << "  لا توجد مشتقات (No derivatives)" << endl;
         return;
     }
     
-    for(auto& a : derive) {
-        cout << "  - " << a.first << " (تكرار/frequency: " << a.second << ")" << endl;
-    }
+    forEachDerivative([](string_view word, int count) {
+        cout << "  - " << word << " (تكرار/frequency: " << count << ")" << endl;
+    });
 }
 
-void Root::display() {
+void Root::display() const {
     cout << "الجذر (Root): " << rootname << endl;
     cout << "عدد المشتقات (Derivative count): " << getDerivativeCount() << endl;
     if(!derive.empty()) {
@@ -0,0 +1,97 @@
+#include "../include/SchemeIndex.h"
+#include <cstring>
+using namespace std;
+
+static int letter_length(unsigned char lead) {
+    return lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+}
+
+// The bytes of one UTF-8 letter packed into an integer edge label.
+static unsigned int letter_key(const char* p, int len) {
+    unsigned int key = 0;
+    memcpy(&key, p, len);
+    return key;
+}
+
+int SchemeIndex::child(int n, unsigned int letter) const {
+    for (const auto& e : m_nodes[n].next)
+        if (e.first == letter) return e.second;
+    return -1;
+}
+
+void SchemeIndex::build(struct hashmap* hashmap_ptr) {
+    m_nodes.assign(1, TrieNode());
+
+    for (struct node* scheme : all_schemes(hashmap_ptr)) {
+        int n = 0;
+        for (const struct scheme_op& op : scheme->value.ops) {
+            if (op.slot != SCHEME_LITERAL) {
+                if (m_nodes[n].wildcard == -1) {
+                    m_nodes[n].wildcard = (int)m_nodes.size();
+                    m_nodes.emplace_back();
+                }
+                n = m_nodes[n].wildcard;
+                continue;
+            }
+            const char* p = scheme->value.lits.data() + op.offset;
+            int i = 0;
+            while (i < op.length) {
+                int len = min(letter_length((unsigned char)p[i]), op.length - i);
+                unsigned int letter = letter_key(p + i, len);
+                int c = child(n, letter);
+                if (c == -1) {
+                    c = (int)m_nodes.size();
+                    m_nodes[n].next.push_back({letter, c});
+                    m_nodes.emplace_back();
+                }
+                n = c;
+                i += len;
+            }
+        }
+        m_nodes[n].schemes.push_back(scheme);
+    }
+
+    m_source  = hashmap_ptr->id;
+    m_version = hashmap_ptr->version;
+}
+
+bool SchemeIndex::isCurrent(const struct hashmap* hashmap_ptr) const {
+    return m_source == hashmap_ptr->id && m_version == hashmap_ptr->version;
+}
+
+void SchemeIndex::walk(int n, const string& word, const LetterSpan* letters, int count, int pos,
+                       LetterSpan* bound, int slots, vector<scheme_match>& out) const {
+    const TrieNode& t = m_nodes[n];
+    if (pos == count) {
+        if (t.schemes.empty()) return;
+        string root;
+        for (int s = 0; s < slots; s++) root.append(word, bound[s].offset, bound[s].length);
+        for (struct node* scheme : t.schemes) out.push_back({scheme, root});
+        return;
+    }
+
+    const LetterSpan& l = letters[pos];
+    int c = child(n, letter_key(word.data() + l.offset, l.length));
+    if (c != -1) walk(c, word, letters, count, pos + 1, bound, slots, out);
+    if (t.wildcard != -1 && slots < MAX_ROOT_SLOTS) {
+        bound[slots] = l;
+        walk(t.wildcard, word, letters, count, pos + 1, bound, slots + 1, out);
+    }
+}
+
+void SchemeIndex::match(const string& word, vector<scheme_match>& out) const {
+    if (m_nodes.empty()) return;
+
+    LetterSpan letters[MAX_WORD_LETTERS];
+    int count = 0;
+    int i = 0;
+    while (i < (int)word.length()) {
+        if (count == MAX_WORD_LETTERS) return;
+        int len = min(letter_length((unsigned char)word[i]), (int)word.length() - i);
+        letters[count++] = {i, len};
+        i += len;
+    }
+
+    LetterSpan bound[MAX_ROOT_SLOTS];
+    walk(0, word, letters, count, 0, bound, 0, out);
+}
@@ -0,0 +1,76 @@
+#include "../include/StringPool.h"
+#include <cstring>
+#include <functional>
+using namespace std;
+
+StringPool& StringPool::global() {
+    static StringPool pool;
+    return pool;
+}
+
+// Text is preceded by a 2-byte length, or 0xFFFF and a 4-byte length for
+// the rare string of 64KB or more.
+string_view StringPool::at(unsigned id) const {
+    const unsigned char* p = (const unsigned char*)m_blocks[m_refs[id] >> 16].get() + (m_refs[id] & 0xffff);
+    size_t len = p[0] | (p[1] << 8);
+    p += 2;
+    if (len == 0xffff) {
+        len = (size_t)p[0] | ((size_t)p[1] << 8) | ((size_t)p[2] << 16) | ((size_t)p[3] << 24);
+        p += 4;
+    }
+    return string_view((const char*)p, len);
+}
+
+// Slot holding s, or the empty slot where it would go.
+size_t StringPool::probe(string_view s, size_t h) const {
+    size_t mask = m_table.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask)
+        if (m_table[i] == NONE || at(m_table[i]) == s) return i;
+}
+
+void StringPool::grow() {
+    m_table.assign(m_table.empty() ? 1024 : m_table.size() * 2, NONE);
+    size_t mask = m_table.size() - 1;
+    for (unsigned id = 0; id < m_refs.size(); id++) {
+        size_t i = hash<string_view>()(at(id)) & mask;
+        while (m_table[i] != NONE) i = (i + 1) & mask;
+        m_table[i] = id;
+    }
+}
+
+unsigned StringPool::intern(string_view s) {
+    if ((m_refs.size() + 1) * 4 > m_table.size() * 3) grow();
+    size_t h = hash<string_view>()(s);
+    size_t slot = probe(s, h);
+    if (m_table[slot] != NONE) return m_table[slot];
+
+    size_t header = s.size() < 0xffff ? 2 : 6;
+    size_t need = header + s.size();
+    if (m_blockUsed + need > BLOCK_BYTES) {
+        m_blocks.emplace_back(new char[max(BLOCK_BYTES, need)]);
+        m_blockUsed = 0;
+    }
+    unsigned char* p = (unsigned char*)m_blocks.back().get() + m_blockUsed;
+    size_t len = header == 2 ? s.size() : 0xffff;
+    p[0] = len & 0xff;
+    p[1] = (len >> 8) & 0xff;
+    if (header == 6)
+        for (int b = 0; b < 4; b++) p[2 + b] = (s.size() >> (8 * b)) & 0xff;
+    memcpy(p + header, s.data(), s.size());
+
+    unsigned id = (unsigned)m_refs.size();
+    m_refs.push_back((unsigned long long)(m_blocks.size() - 1) << 16 | m_blockUsed);
+    m_blockUsed += need;
+    m_table[slot] = id;
+    return id;
+}
+
+unsigned StringPool::find(string_view s) const {
+    if (m_table.empty()) return NONE;
+    return m_table[probe(s, hash<string_view>()(s))];
+}
+
+size_t StringPool::bytes() const {
+    return m_blocks.size() * BLOCK_BYTES + m_refs.capacity() * sizeof(unsigned long long)
+         + m_table.capacity() * sizeof(unsigned);
+}
@@ -0,0 +1,86 @@
+#include "../include/ThreadPool.h"
+using namespace std;
+
+static thread_local int t_worker = -1;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; i++) m_queues.emplace_back(new Queue());
+    for (unsigned i = 0; i < threads; i++) m_workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> lk(m_sleepLock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (thread& t : m_workers) t.join();
+}
+
+int ThreadPool::currentWorker() { return t_worker; }
+
+// Tasks submitted from a worker stay on that worker's deque; the rest are
+// spread round-robin.
+void ThreadPool::submit(function<void()> task) {
+    unsigned q = t_worker >= 0 ? (unsigned)t_worker
+                               : m_nextQueue.fetch_add(1) % (unsigned)m_queues.size();
+    m_pending++;
+    {
+        lock_guard<mutex> lk(m_queues[q]->lock);
+        m_queues[q]->tasks.push_back(std::move(task));
+    }
+    {
+        lock_guard<mutex> lk(m_sleepLock);
+        m_queued++;
+    }
+    m_wake.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> lk(m_sleepLock);
+    m_idle.wait(lk, [this] { return m_pending.load() == 0; });
+}
+
+bool ThreadPool::popLocal(unsigned worker, function<void()>& task) {
+    Queue& q = *m_queues[worker];
+    lock_guard<mutex> lk(q.lock);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned thief, function<void()>& task) {
+    unsigned n = (unsigned)m_queues.size();
+    for (unsigned k = 1; k < n; k++) {
+        Queue& q = *m_queues[(thief + k) % n];
+        lock_guard<mutex> lk(q.lock);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned worker) {
+    t_worker = (int)worker;
+    function<void()> task;
+    while (true) {
+        if (popLocal(worker, task) || steal(worker, task)) {
+            m_queued--;
+            task();
+            task = nullptr;
+            if (--m_pending == 0) {
+                lock_guard<mutex> lk(m_sleepLock);
+                m_idle.notify_all();
+            }
+            continue;
+        }
+        unique_lock<mutex> lk(m_sleepLock);
+        m_wake.wait(lk, [this] { return m_stop || m_queued.load() > 0; });
+        if (m_stop && m_queued.load() == 0) return;
+    }
+}
@@ -1,35 +1,124 @@
 #include "../include/core_engine.h"
+#include "../include/ThreadPool.h"
 #include <string>
 #include <iostream>
 #include <cctype>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
+// Words of every tree root x table scheme. On the first use after either
+// side changes, rows and columns that appeared are generated and those
+// that went away are dropped; the rest is kept. If the grid would pass the
+// budget it is released and callers generate on the fly.
+static struct {
+    DerivationMatrix grid;
+    vector<struct node*> schemes;     // scheme of each column
+    long long hashmap_id = -1;
+    long long hashmap_version = -1;
+    long long tree_id = -1;
+    long long tree_version = -1;
+    matrix_stats stats = {false, (size_t)64 << 20, false, 0, 0, 0, 0, 0, 0, 0};
+} derivation_matrix;
 
+static struct node* matrix_scheme(size_t column) {
+    return derivation_matrix.schemes[column];
+}
 
-string apply_algo(const string& algo, const string& root) {
-    string result = "";
-    int j = 0;
-    while (j < (int)algo.length()) {
-        if (j + 7 <= (int)algo.length() && algo.substr(j, 5) == "root[") {
-            char digitChar = algo[j + 5];
-            if (isdigit(digitChar) && algo[j + 6] == ']') {
-                int idx        = digitChar - '0';
-                int byteOffset = idx * 2;   // each Arabic char = 2 UTF-8 bytes
-                if (byteOffset + 1 < (int)root.length()) {
-                    result += root[byteOffset];
-                    result += root[byteOffset + 1];
-                }
-                j += 7;   // skip past "root[X]"
-                continue;
-            }
+static const DerivationMatrix* current_matrix(struct hashmap* hashmap_ptr, const BinarySearchTree* tree);
+
+// Results of validate_word, keyed by (root, word), and of generate, keyed
+// by (root, scheme). They hold for one generation, which moves on whenever
+// the tree's roots or the table's schemes change.
+static struct {
+    bool enabled = true;
+    ResultCache<struct node*> validated{1 << 16};
+    ResultCache<string> generated{1 << 14};
+    long long hashmap_id = -1;
+    long long hashmap_version = -1;
+    long long tree_id = -1;
+    long long tree_version = -1;
+    long long generation = 0;
+} result_cache;
+
+static long long cache_generation(struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    if (result_cache.hashmap_id != hashmap_ptr->id || result_cache.hashmap_version != hashmap_ptr->version
+        || result_cache.tree_id != (tree ? tree->id() : -1) || result_cache.tree_version != (tree ? tree->version() : -1)) {
+        result_cache.hashmap_id = hashmap_ptr->id;
+        result_cache.hashmap_version = hashmap_ptr->version;
+        result_cache.tree_id = tree ? tree->id() : -1;
+        result_cache.tree_version = tree ? tree->version() : -1;
+        result_cache.generation++;
+    }
+    return result_cache.generation;
+}
+
+void split_root(const string& root, struct root_letters* letters) {
+    letters->count = 0;
+    letters->bytes[0] = 0;
+    size_t i = 0;
+    while (i < root.length() && letters->count < ROOT_MAX_LETTERS) {
+        unsigned char lead = (unsigned char)root[i];
+        size_t len = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        len = min(len, root.length() - i);
+        letters->ptr[letters->count] = root.data() + i;
+        letters->len[letters->count] = (unsigned char)len;
+        letters->count++;
+        i += len;
+        letters->bytes[letters->count] = (unsigned short)i;
+    }
+    // Too long to hold: count -1 fits no scheme, rather than the first letters.
+    if (i < root.length()) letters->count = -1;
+}
+
+// A scheme applies only to a root with exactly one letter per slot; for
+// any other root there is no word (apply_scheme gives an empty one and
+// match_scheme never matches).
+bool scheme_fits(const struct inside& scheme, const struct root_letters& letters) {
+    return letters.count == scheme.slots;
+}
+
+// Runs the compiled ops into out without allocating. Returns the length of
+// the word, 0 if the scheme does not fit the root; only the first cap bytes
+// are written if it does not fit the buffer.
+size_t apply_scheme(const struct inside& scheme, const struct root_letters& letters, char* out, size_t cap) {
+    if (!scheme_fits(scheme, letters)) return 0;
+    size_t n = 0;
+    for (const struct scheme_op& op : scheme.ops) {
+        const char* src;
+        size_t len;
+        if (op.slot == SCHEME_LITERAL) {
+            src = scheme.lits.data() + op.offset;
+            len = op.length;
+        } else {
+            src = letters.ptr[op.slot];
+            len = letters.len[op.slot];
         }
-        result += algo[j];
-        j++;
+        if (n + len <= cap) memcpy(out + n, src, len);
+        n += len;
     }
-    return result;
+    return n;
 }
 
+// The whole word, whatever its length: the view points into out->buf, or
+// into out->spill when the word is longer than the buffer. Callers never
+// see a truncated buffer.
+string_view apply_scheme(const struct inside& scheme, const struct root_letters& letters, struct word_buffer* out) {
+    size_t n = apply_scheme(scheme, letters, out->buf, sizeof out->buf);
+    if (n <= sizeof out->buf) return string_view(out->buf, n);
+    out->spill.assign(n, '\0');
+    apply_scheme(scheme, letters, &out->spill[0], n);
+    return out->spill;
+}
 
+string apply_scheme(const struct inside& scheme, const string& root) {
+    struct root_letters letters;
+    split_root(root, &letters);
+    struct word_buffer out;
+    return string(apply_scheme(scheme, letters, &out));
+}
 
 void generate(string root, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
     Node* rootNode = tree->getRootNode(root);
@@ -42,64 +131,691 @@ void generate(string root, struct hashmap* hashmap_ptr, BinarySearchTree* tree)
    cout<<"Please define the number of schemes you want to generate with the selected root : "<<endl;
     int n;cin>>n;
     string scheme;
-    vector<string>v(n);
+    vector<string>v;
     for(int i=0;i<n;i++){
         cout<<"Give the scheme number = "<<i+1<<endl;
         cin>>scheme;
-    
-       
-        int pos = search(scheme, hashmap_ptr);
-        if (pos == -1) {
+
+        if (search(scheme, hashmap_ptr) == -1) {
             cout << "✗ Scheme \"" << scheme << "\" not found in hash table." << endl;
             continue;
         }
+        v.push_back(scheme);
+    }
+    if (v.empty()) return;
 
-        struct node* current_node = hashmap_ptr->v[pos];
-        while (current_node->key != scheme){
-           current_node = current_node->next;
-        }
-   
-        string word = apply_algo(current_node->value.algo, root);
-
-        cout << "  Root   : " << root   << endl;
-        cout << "  Scheme : " << scheme << endl;
+    auto store = [&](const string& r, const struct node* s, const char* w, size_t len) {
+        string word(w, len);
+        cout << "  Root   : " << r      << endl;
+        cout << "  Scheme : " << s->key << endl;
         cout << "  Word   : " << word   << endl;
 
-        rootNode->getRootObject().addderviation(word);
+        tree->addDerivation(r, s->key, word);
         cout << "✓ \"" << word << "\" stored as derivative of \""
-             << root << "\" in the AVL tree." << endl;
+             << r << "\" in the AVL tree." << endl;
+    };
+    long long generation = cache_generation(hashmap_ptr, tree);
+    const DerivationMatrix* matrix = current_matrix(hashmap_ptr, tree);
+    long long row = matrix ? matrix->row(root) : -1;
+    for (const string& name : v) {
+        struct node* s = find_scheme(name, hashmap_ptr);
+        string word;
+        if (!result_cache.enabled || !result_cache.generated.get(root, name, generation, word)) {
+            if (row >= 0) {
+                derivation_matrix.stats.hits++;
+                word = string(matrix->at((size_t)row, (size_t)matrix->column(name)));
+            } else {
+                if (derivation_matrix.stats.enabled) derivation_matrix.stats.misses++;
+                word = apply_scheme(s->value, root);
+            }
+            if (result_cache.enabled) result_cache.generated.put(root, name, generation, word);
+        }
+        if (word.empty()) {
+            cout << "✗ Scheme \"" << name << "\" takes " << s->value.slots << " root letters; \""
+                 << root << "\" does not fit it." << endl;
+            continue;
+        }
+        store(root, s, word.data(), word.length());
     }
 }
 
+// An empty name list means every scheme in the table; unknown names are skipped.
+static vector<struct node*> resolve_schemes(const vector<string>& names, struct hashmap* hashmap_ptr) {
+    vector<struct node*> schemes;
+    if (names.empty()) return all_schemes(hashmap_ptr);
+    for (const string& name : names)
+        if (struct node* n = find_scheme(name, hashmap_ptr)) schemes.push_back(n);
+    return schemes;
+}
 
-void validate(string word, string root, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
-    for (int i = 0; i < (int)hashmap_ptr->v.size(); i++) {
-        struct node* current_node = hashmap_ptr->v[i];
-        while (current_node != NULL) {
-            string generated = apply_algo(current_node->value.algo, root);
-            if (generated == word) {
-                cout << "OUI — \"" << word << "\" matches scheme \""
-                     << current_node->key << "\" with root \"" << root << "\"" << endl;
-
-               
-                Node* rootNode = tree->getRootNode(root);
-                if (rootNode) {
-                    rootNode->getRootObject().addderviation(word);
-                    cout << "✓ \"" << word << "\" stored as derivative of \""
-                         << root << "\" in the AVL tree." << endl;
-                } else {
-                    cout << "  ℹ Root \"" << root
-                         << "\" not in AVL tree "
-                         << endl;
+// Streams scheme x root words to sink without storing them anywhere;
+// pairs where the scheme does not fit the root produce nothing.
+// Returns the number of words produced.
+long long generate_words(const vector<string>& roots, const vector<string>& schemes,
+                         struct hashmap* hashmap_ptr, const word_sink& sink) {
+    vector<struct node*> resolved = resolve_schemes(schemes, hashmap_ptr);
+    long long count = 0;
+    struct word_buffer out;
+    struct root_letters letters;
+    for (const string& root : roots) {
+        split_root(root, &letters);
+        for (struct node* scheme : resolved) {
+            if (!scheme_fits(scheme->value, letters)) continue;
+            string_view word = apply_scheme(scheme->value, letters, &out);
+            sink(root, scheme, word.data(), word.length());
+            count++;
+        }
+    }
+    return count;
+}
+
+// (root, word) pairs, in root order then scheme order.
+vector<pair<string, string>> generate_words(const vector<string>& roots, const vector<string>& schemes,
+                                            struct hashmap* hashmap_ptr) {
+    vector<pair<string, string>> words;
+    generate_words(roots, schemes, hashmap_ptr,
+                   [&](const string& r, const struct node*, const char* w, size_t len) {
+        words.emplace_back(r, string(w, len));
+    });
+    return words;
+}
+
+// Writes every root in the tree x every scheme as "word<TAB>root<TAB>scheme"
+// lines. Blocks of roots are formatted in parallel and written in order, so
+// the file is identical for any thread count. Returns -1 if the file cannot
+// be opened or a write fails, otherwise the number of words written.
+long long write_lexicon(const string& filename, struct hashmap* hashmap_ptr, BinarySearchTree* tree,
+                        unsigned threads) {
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) return -1;
+
+    vector<string> roots;
+    tree->forEach([&](const Root& r) { roots.push_back(r.getRoot()); });
+    vector<struct node*> schemes = resolve_schemes({}, hashmap_ptr);
+    if (roots.empty() || schemes.empty()) {
+        file.close();
+        return file ? 0 : -1;
+    }
+
+    const size_t ROOTS_PER_BLOCK = 256;
+    size_t blockCount = (roots.size() + ROOTS_PER_BLOCK - 1) / ROOTS_PER_BLOCK;
+    vector<string> blocks(blockCount);
+    vector<long long> counts(blockCount, 0);
+    vector<char> ready(blockCount, 0);
+    mutex lock;
+    condition_variable done;
+
+    ThreadPool pool(threads);
+    const size_t maxAhead = 4 * pool.size();
+    size_t submitted = 0;
+    long long written = 0;
+
+    auto submitBlock = [&](size_t b) {
+        pool.submit([&, b] {
+            string out;
+            long long count = 0;
+            out.reserve(ROOTS_PER_BLOCK * schemes.size() * 32);
+            struct word_buffer word;
+            struct root_letters letters;
+            size_t end = min(roots.size(), (b + 1) * ROOTS_PER_BLOCK);
+            for (size_t i = b * ROOTS_PER_BLOCK; i < end; i++) {
+                split_root(roots[i], &letters);
+                for (struct node* scheme : schemes) {
+                    if (!scheme_fits(scheme->value, letters)) continue;
+                    out += apply_scheme(scheme->value, letters, &word);
+                    out += '\t';
+                    out += roots[i];
+                    out += '\t';
+                    out += scheme->key;
+                    out += '\n';
+                    count++;
                 }
-                return;
             }
-            current_node = current_node->next;
+            lock_guard<mutex> lk(lock);
+            blocks[b].swap(out);
+            counts[b] = count;
+            ready[b] = 1;
+            done.notify_all();
+        });
+    };
+
+    for (size_t b = 0; b < blockCount; b++) {
+        while (submitted < blockCount && submitted < b + maxAhead) submitBlock(submitted++);
+        string out;
+        {
+            unique_lock<mutex> lk(lock);
+            done.wait(lk, [&] { return ready[b] != 0; });
+            out.swap(blocks[b]);
         }
+        file.write(out.data(), (streamsize)out.size());
+        if (!file) break;
+        written += counts[b];
+    }
+    pool.wait();
+    file.flush();
+    if (!file) return -1;
+    file.close();
+    return file ? written : -1;
+}
+
+// Every root x scheme word, compiled into a LexiconAutomaton file.
+// Returns the number of distinct words, or -1 if the file cannot be written.
+long long compile_lexicon(const string& filename, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
+    vector<string> roots, schemeNames;
+    tree->forEach([&](const Root& r) { roots.push_back(r.getRoot()); });
+    vector<struct node*> schemes = resolve_schemes({}, hashmap_ptr);
+    for (struct node* s : schemes) schemeNames.push_back(s->key);
+
+    string text;
+    vector<lexicon_word> words;
+    words.reserve(roots.size() * schemeNames.size());
+    struct word_buffer out;
+    struct root_letters letters;
+    for (uint32_t r = 0; r < roots.size(); r++) {
+        split_root(roots[r], &letters);
+        for (uint32_t s = 0; s < schemes.size(); s++) {
+            if (!scheme_fits(schemes[s]->value, letters)) continue;
+            string_view word = apply_scheme(schemes[s]->value, letters, &out);
+            words.push_back({(uint32_t)text.size(), (uint32_t)word.length(), r, s});
+            text.append(word);
+        }
+    }
+    return LexiconAutomaton::write(filename, roots, schemeNames, text, words);
+}
+
+// The lexicon loaded with load_lexicon(). validate_word and analyze answer
+// from it while the tree and the table are still the ones it was compiled
+// from; any change to either sends them back to the matcher until a new
+// lexicon is compiled and loaded.
+static struct {
+    LexiconAutomaton automaton;
+    long long hashmap_id = -1;
+    long long hashmap_version = -1;
+    long long tree_id = -1;
+    long long tree_version = -1;
+    lexicon_stats stats = {false, false, 0, 0, 0, 0, 0};
+} lexicon_file;
+
+// The file stays loaded for lookups even when its roots and schemes are
+// not those of the tree and the table; it is just never used to validate.
+bool load_lexicon(const string& filename, struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    LexiconAutomaton& lexicon = lexicon_file.automaton;
+    lexicon_stats& stats = lexicon_file.stats;
+    stats = {false, false, 0, 0, 0, 0, 0};
+    lexicon_file.tree_id = -1;
+    if (!lexicon.open(filename)) return false;
+
+    bool matched = lexicon.rootCount() == (uint32_t)tree->getNodeCount()
+                && lexicon.schemeCount() == (uint32_t)all_schemes(hashmap_ptr).size();
+    for (uint32_t i = 0; matched && i < lexicon.rootCount(); i++)
+        matched = tree->contains(string(lexicon.rootName(i)));
+    for (uint32_t i = 0; matched && i < lexicon.schemeCount(); i++)
+        matched = find_scheme(string(lexicon.schemeName(i)), hashmap_ptr) != NULL;
+
+    lexicon_file.hashmap_id = hashmap_ptr->id;
+    lexicon_file.hashmap_version = hashmap_ptr->version;
+    lexicon_file.tree_id = tree->id();
+    lexicon_file.tree_version = tree->version();
+    stats.loaded = true;
+    stats.matched = matched;
+    stats.words = lexicon.wordCount();
+    stats.states = lexicon.stateCount();
+    stats.bytes = lexicon.fileSize();
+    return true;
+}
+
+const LexiconAutomaton& loaded_lexicon() {
+    return lexicon_file.automaton;
+}
+
+lexicon_stats loaded_lexicon_stats() {
+    return lexicon_file.stats;
+}
+
+// The loaded lexicon if it was compiled from this tree and table as they
+// are now, or NULL.
+static const LexiconAutomaton* current_lexicon(const struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    if (!lexicon_file.stats.matched || tree == NULL || lexicon_file.tree_id != tree->id()
+        || lexicon_file.tree_version != tree->version() || lexicon_file.hashmap_id != hashmap_ptr->id
+        || lexicon_file.hashmap_version != hashmap_ptr->version)
+        return NULL;
+    return &lexicon_file.automaton;
+}
+
+// First scheme the lexicon lists for (root, word), or NULL.
+static struct node* lexicon_scheme(const LexiconAutomaton& lexicon, const string& word, const string& root,
+                                   struct hashmap* hashmap_ptr) {
+    string_view scheme;
+    lexicon.lookup(word, [&](string_view r, string_view s) {
+        if (scheme.empty() && r == root) scheme = s;
+    });
+    return scheme.empty() ? NULL : find_scheme(string(scheme), hashmap_ptr);
+}
+
+// Checks the loaded lexicon against a fresh generation: each distinct word
+// must be found at its sorted position, with exactly the (root, scheme)
+// pairs that generate it. Returns the number of words that fail, or -1
+// when no lexicon is loaded.
+long long verify_lexicon(struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
+    const LexiconAutomaton& lexicon = lexicon_file.automaton;
+    if (!lexicon.isOpen()) return -1;
+
+    vector<string> roots;
+    tree->forEach([&](const Root& r) { roots.push_back(r.getRoot()); });
+    map<string, vector<pair<string, string>>> expected;
+    generate_words(roots, {}, hashmap_ptr, [&](const string& r, const struct node* s, const char* w, size_t len) {
+        expected[string(w, len)].push_back({r, s->key});
+    });
+
+    long long failed = llabs((long long)lexicon.wordCount() - (long long)expected.size());
+    long long rank = 0;
+    vector<pair<string, string>> found;
+    for (auto& e : expected) {
+        found.clear();
+        lexicon.lookup(e.first, [&](string_view r, string_view s) { found.push_back({string(r), string(s)}); });
+        sort(found.begin(), found.end());
+        sort(e.second.begin(), e.second.end());
+        if (lexicon.find(e.first) != rank++ || found != e.second) failed++;
+    }
+    return failed;
+}
+
+// Rebuilt lazily whenever the hashmap's version moves on.
+const SchemeIndex& scheme_index(struct hashmap* hashmap_ptr) {
+    static SchemeIndex index;
+    if (!index.isCurrent(hashmap_ptr)) index.build(hashmap_ptr);
+    return index;
+}
+
+// Literal runs are usually a few bytes: 16 at a time with SSE2, then 8,
+// then single bytes, returning at the first block that differs.
+static bool equal_bytes(const char* a, const char* b, size_t n) {
+#ifdef __SSE2__
+    for (; n >= 16; a += 16, b += 16, n -= 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)a);
+        __m128i y = _mm_loadu_si128((const __m128i*)b);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) return false;
+    }
+#endif
+    for (; n >= 8; a += 8, b += 8, n -= 8) {
+        unsigned long long x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        if (x != y) return false;
+    }
+    for (; n > 0; a++, b++, n--)
+        if (*a != *b) return false;
+    return true;
+}
+
+// Walks the compiled ops against word in place: the length is checked
+// first, then each literal run and root letter, stopping at the first
+// mismatch. Same result as comparing word with apply_scheme(scheme, root).
+bool match_scheme(const char* word, size_t len, const struct inside& scheme, const struct root_letters& letters) {
+    if (!scheme_fits(scheme, letters) || scheme.lits.length() + letters.bytes[letters.count] != len) return false;
+
+    size_t n = 0;
+    for (const struct scheme_op& op : scheme.ops) {
+        if (op.slot == SCHEME_LITERAL) {
+            if (!equal_bytes(word + n, scheme.lits.data() + op.offset, op.length)) return false;
+            n += op.length;
+        } else {
+            if (!equal_bytes(word + n, letters.ptr[op.slot], letters.len[op.slot])) return false;
+            n += letters.len[op.slot];
+        }
+    }
+    return true;
+}
+
+// Every scheme keyed by slots << 16 | literal bytes, sorted, so a word
+// only meets the schemes whose length can produce it. Rebuilt lazily
+// whenever the hashmap's version moves on.
+static const vector<pair<unsigned, struct node*>>& schemes_by_shape(struct hashmap* hashmap_ptr) {
+    static long long owner = -1;
+    static long long version = -1;
+    static vector<pair<unsigned, struct node*>> shapes;
+    if (owner != hashmap_ptr->id || version != hashmap_ptr->version) {
+        shapes.clear();
+        for (struct node* n : all_schemes(hashmap_ptr))
+            shapes.push_back({(unsigned)n->value.slots << 16 | (unsigned)n->value.lits.length(), n});
+        sort(shapes.begin(), shapes.end(),
+             [](const pair<unsigned, struct node*>& a, const pair<unsigned, struct node*>& b) { return a.first < b.first; });
+        owner = hashmap_ptr->id;
+        version = hashmap_ptr->version;
+    }
+    return shapes;
+}
+
+// The scheme that turns root into word, or NULL.
+struct node* match_scheme(const string& word, const string& root, struct hashmap* hashmap_ptr) {
+    struct root_letters letters;
+    split_root(root, &letters);
+    const vector<pair<unsigned, struct node*>>& shapes = schemes_by_shape(hashmap_ptr);
+    auto byKey = [](const pair<unsigned, struct node*>& p, unsigned key) { return p.first < key; };
+
+    // Only schemes with one slot per root letter can fit.
+    if (letters.count < 0) return NULL;
+    size_t rootBytes = letters.bytes[letters.count];
+    if (word.length() < rootBytes || word.length() - rootBytes > 0xffff) return NULL;
+    unsigned key = (unsigned)letters.count << 16 | (unsigned)(word.length() - rootBytes);
+    for (auto it = lower_bound(shapes.begin(), shapes.end(), key, byKey); it != shapes.end() && it->first == key; ++it)
+        if (match_scheme(word.data(), word.length(), it->second->value, letters)) return it->second;
+    return NULL;
+}
+
+// Bloom filter over hash(root, word) for every word the tree's roots and
+// the table's schemes generate. It is rebuilt on the first query after
+// either side changes; roots outside the tree bypass it.
+static struct {
+    BloomFilter bloom;
+    long long hashmap_id = -1;
+    long long hashmap_version = -1;
+    long long tree_id = -1;
+    long long tree_version = -1;
+    filter_stats stats = {true, 0.01, 0, 0, 0, 0, 0, 0, 0};
+} validation_filter;
+
+static unsigned long long pair_hash(unsigned long long rootHash, string_view word) {
+    return hash_function(word) ^ (rootHash * 0x9e3779b97f4a7c15ULL);
+}
+
+static void rebuild_validation_filter(struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    vector<struct node*> schemes = resolve_schemes({}, hashmap_ptr);
+    long long words = (long long)tree->getNodeCount() * (long long)schemes.size();
+    validation_filter.bloom.reset((size_t)words, validation_filter.stats.fp_rate);
+
+    struct word_buffer out;
+    words = 0;
+    tree->forEach([&](const Root& r) {
+        struct root_letters letters;
+        split_root(r.getRoot(), &letters);
+        unsigned long long rootHash = hash_function(r.getRoot());
+        for (struct node* s : schemes)
+            if (scheme_fits(s->value, letters)) {
+                validation_filter.bloom.add(pair_hash(rootHash, apply_scheme(s->value, letters, &out)));
+                words++;
+            }
+    });
+
+    validation_filter.hashmap_id = hashmap_ptr->id;
+    validation_filter.hashmap_version = hashmap_ptr->version;
+    validation_filter.tree_id = tree->id();
+    validation_filter.tree_version = tree->version();
+    validation_filter.stats.words = words;
+    validation_filter.stats.bits = validation_filter.bloom.bitCount();
+    validation_filter.stats.hashes = validation_filter.bloom.hashCount();
+    validation_filter.stats.rebuilds++;
+}
+
+static void sync_matrix(struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    DerivationMatrix& grid = derivation_matrix.grid;
+    matrix_stats& stats = derivation_matrix.stats;
+    bool sameOwners = derivation_matrix.hashmap_id == hashmap_ptr->id && derivation_matrix.tree_id == tree->id();
+    bool schemesChanged = !sameOwners || derivation_matrix.hashmap_version != hashmap_ptr->version;
+    long long since = derivation_matrix.tree_version;
+    bool wasOver = stats.over_budget;
+    derivation_matrix.hashmap_id = hashmap_ptr->id;
+    derivation_matrix.hashmap_version = hashmap_ptr->version;
+    derivation_matrix.tree_id = tree->id();
+    derivation_matrix.tree_version = tree->version();
+    stats.syncs++;
+
+    // Estimated at two bytes per root letter plus the pool's own overhead.
+    vector<struct node*> schemes = resolve_schemes({}, hashmap_ptr);
+    size_t perRow = 0;
+    for (struct node* s : schemes) perRow += 2 * sizeof(unsigned) + s->value.lits.length() + 2 * s->value.slots + 8;
+    stats.over_budget = (size_t)tree->getNodeCount() * perRow > stats.budget;
+    if (stats.over_budget) {
+        grid.clear();
+        derivation_matrix.schemes.clear();
+        stats.rows = stats.columns = 0;
+        stats.bytes = 0;
+        return;
+    }
+
+    // Rows follow the tree's journal, so only roots added or deleted since
+    // the last sync are touched. A new owner, a grid released for the
+    // budget, a journal that no longer reaches back far enough, or a pool
+    // holding more dropped words than live ones means a full rebuild.
+    vector<string> addedRoots;
+    bool full = !sameOwners || wasOver || grid.waste() > grid.rows() * grid.columns() + 4096
+             || !tree->changesSince(since, [&](bool added, const string& root) {
+                    if (added) {
+                        grid.addRow(root);
+                        addedRoots.push_back(root);
+                    } else {
+                        grid.removeRow(root);
+                    }
+                });
+    if (full) {
+        grid.clear();
+        addedRoots.clear();
+        tree->forEach([&](const Root& r) { grid.addRow(r.getRoot()); });
+        schemesChanged = true;
+    }
+    vector<size_t> addedColumns;
+    if (schemesChanged) {
+        vector<string_view> names;
+        for (struct node* s : schemes) names.push_back(s->key);
+        addedColumns = grid.setColumns(names);
+        derivation_matrix.schemes.assign(grid.columns(), NULL);
+        for (struct node* s : schemes) derivation_matrix.schemes[grid.column(s->key)] = s;
+    }
+
+    // New columns are filled down every row, new rows across every column.
+    struct word_buffer out;
+    struct root_letters letters;
+    auto fill = [&](size_t r, size_t c) {
+        grid.set(r, c, apply_scheme(derivation_matrix.schemes[c]->value, letters, &out));
+        stats.generated++;
+    };
+    if (!addedColumns.empty())
+        for (size_t r = 0; r < grid.rows(); r++) {
+            string root(grid.rowRoot(r));
+            split_root(root, &letters);
+            for (size_t c : addedColumns) fill(r, c);
+        }
+    for (const string& root : addedRoots) {
+        long long r = grid.row(root);
+        if (r < 0) continue;
+        split_root(root, &letters);
+        for (size_t c = 0; c < grid.columns(); c++)
+            if (!grid.filled((size_t)r, c)) fill((size_t)r, c);
+    }
+    stats.rows = (long long)grid.rows();
+    stats.columns = (long long)grid.columns();
+    stats.bytes = grid.bytes();
+}
+
+// The grid for the current tree and table, or NULL when it is disabled or
+// over budget.
+static const DerivationMatrix* current_matrix(struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    matrix_stats& stats = derivation_matrix.stats;
+    if (!stats.enabled || tree == NULL) return NULL;
+    if (derivation_matrix.hashmap_id != hashmap_ptr->id || derivation_matrix.hashmap_version != hashmap_ptr->version
+        || derivation_matrix.tree_id != tree->id() || derivation_matrix.tree_version != tree->version())
+        sync_matrix(hashmap_ptr, tree);
+    return stats.over_budget ? NULL : &derivation_matrix.grid;
+}
+
+// A budget change takes effect at the next use; disabling releases the grid.
+void set_derivation_matrix(bool enabled, size_t budget) {
+    matrix_stats& stats = derivation_matrix.stats;
+    stats.enabled = enabled;
+    if (budget > 0) stats.budget = budget;
+    stats.hits = stats.misses = 0;
+    derivation_matrix.tree_id = -1;
+    if (!enabled) {
+        derivation_matrix.grid.clear();
+        derivation_matrix.schemes.clear();
+        stats.rows = stats.columns = 0;
+        stats.bytes = 0;
+    }
+}
+
+matrix_stats derivation_matrix_stats() {
+    return derivation_matrix.stats;
+}
+
+// A new capacity empties both caches and restarts their counters.
+void set_result_cache(bool enabled, size_t capacity) {
+    result_cache.enabled = enabled;
+    if (capacity > 0) {
+        result_cache.validated.reset(capacity);
+        result_cache.generated.reset(max<size_t>(capacity / 4, 1));
+    }
+}
+
+cache_stats validation_cache_stats() {
+    cache_stats stats = result_cache.validated.stats();
+    stats.enabled = result_cache.enabled;
+    return stats;
+}
+
+cache_stats generation_cache_stats() {
+    cache_stats stats = result_cache.generated.stats();
+    stats.enabled = result_cache.enabled;
+    return stats;
+}
+
+// The scheme that turns root into word, read from the matrix row of root;
+// match_scheme when the root has no row.
+static struct node* lookup_scheme(const string& word, const string& root, struct hashmap* hashmap_ptr,
+                                  const BinarySearchTree* tree) {
+    if (const DerivationMatrix* matrix = current_matrix(hashmap_ptr, tree)) {
+        long long row = matrix->row(root);
+        if (row >= 0) {
+            derivation_matrix.stats.hits++;
+            long long column = matrix->find((size_t)row, word);
+            return column < 0 ? NULL : matrix_scheme((size_t)column);
+        }
+    }
+    if (derivation_matrix.stats.enabled) derivation_matrix.stats.misses++;
+    return match_scheme(word, root, hashmap_ptr);
+}
+
+// Lookup behind the pre-filter: a (root, word) pair the filter has never
+// seen cannot match, so it is answered NON without any scheme scan.
+static struct node* filtered_lookup(const string& word, const string& root, struct hashmap* hashmap_ptr,
+                                    const BinarySearchTree* tree) {
+    filter_stats& stats = validation_filter.stats;
+    if (!stats.enabled || tree == NULL || !tree->contains(root))
+        return lookup_scheme(word, root, hashmap_ptr, tree);
+
+    if (validation_filter.hashmap_id != hashmap_ptr->id || validation_filter.hashmap_version != hashmap_ptr->version
+        || validation_filter.tree_id != tree->id() || validation_filter.tree_version != tree->version())
+        rebuild_validation_filter(hashmap_ptr, tree);
+
+    stats.queries++;
+    if (!validation_filter.bloom.mayContain(pair_hash(hash_function(root), word))) {
+        stats.rejected++;
+        return NULL;
+    }
+    struct node* scheme = lookup_scheme(word, root, hashmap_ptr, tree);
+    if (scheme == NULL) stats.false_positives++;
+    return scheme;
+}
+
+// The cached answer while nothing has changed since it was computed.
+// Uncached validation: from the lexicon when it is current and covers
+// root, otherwise through the pre-filter.
+static struct node* find_producer(const string& word, const string& root, struct hashmap* hashmap_ptr,
+                                  const BinarySearchTree* tree) {
+    const LexiconAutomaton* lexicon = current_lexicon(hashmap_ptr, tree);
+    if (lexicon && tree->contains(root)) {
+        lexicon_file.stats.hits++;
+        return lexicon_scheme(*lexicon, word, root, hashmap_ptr);
+    }
+    if (lexicon_file.stats.loaded) lexicon_file.stats.misses++;
+    return filtered_lookup(word, root, hashmap_ptr, tree);
+}
+
+struct node* validate_word(const string& word, const string& root, struct hashmap* hashmap_ptr, const BinarySearchTree* tree) {
+    if (!result_cache.enabled) return find_producer(word, root, hashmap_ptr, tree);
+    long long generation = cache_generation(hashmap_ptr, tree);
+    struct node* scheme;
+    if (result_cache.validated.get(root, word, generation, scheme)) return scheme;
+    scheme = find_producer(word, root, hashmap_ptr, tree);
+    result_cache.validated.put(root, word, generation, scheme);
+    return scheme;
+}
+
+// A new rate only takes effect at the next rebuild, so it forces one;
+// the counters restart with the new setting.
+void set_validation_filter(bool enabled, double fp_rate) {
+    filter_stats& stats = validation_filter.stats;
+    stats.enabled = enabled;
+    if (fp_rate > 0 && fp_rate < 1) stats.fp_rate = fp_rate;
+    stats.queries = stats.rejected = stats.false_positives = 0;
+    validation_filter.tree_id = -1;
+    validation_filter.bloom.reset(0, validation_filter.stats.fp_rate);
+}
+
+filter_stats validation_filter_stats() {
+    return validation_filter.stats;
+}
+
+void validate(string word, string root, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
+    struct node* scheme = validate_word(word, root, hashmap_ptr, tree);
+    if (scheme != NULL) {
+        cout << "OUI — \"" << word << "\" matches scheme \""
+             << scheme->key << "\" with root \"" << root << "\"" << endl;
+
+        if (tree->addDerivation(root, scheme->key, word)) {
+            cout << "✓ \"" << word << "\" stored as derivative of \""
+                 << root << "\" in the AVL tree." << endl;
+        } else {
+            cout << "  ℹ Root \"" << root
+                 << "\" not in AVL tree "
+                 << endl;
+        }
+        return;
     }
     cout << "NON — \"" << word << "\" does not match any scheme for root \""
          << root << "\"" << endl;
 }
+// Every (root, scheme) pair that yields word, keeping only roots in the tree.
+// out is cleared first so one vector can be reused across many tokens.
+// Read from the lexicon when it is current.
+void analyze(const string& word, struct hashmap* hashmap_ptr, BinarySearchTree* tree, vector<scheme_match>& out) {
+    if (const LexiconAutomaton* lexicon = current_lexicon(hashmap_ptr, tree)) {
+        lexicon_file.stats.hits++;
+        out.clear();
+        lexicon->lookup(word, [&](string_view r, string_view s) {
+            out.push_back({find_scheme(string(s), hashmap_ptr), string(r)});
+        });
+        return;
+    }
+    if (lexicon_file.stats.loaded) lexicon_file.stats.misses++;
+    analyze(word, scheme_index(hashmap_ptr), *tree, out);
+}
+
+// Read-only on both structures, so it is safe to call from several threads
+// while neither is being modified.
+void analyze(const string& word, const SchemeIndex& index, const BinarySearchTree& tree, vector<scheme_match>& out) {
+    out.clear();
+    index.match(word, out);
+    size_t kept = 0;
+    for (size_t i = 0; i < out.size(); i++)
+        if (tree.contains(out[i].root)) {
+            if (kept != i) out[kept] = std::move(out[i]);
+            kept++;
+        }
+    out.resize(kept);
+}
+
+void displayAnalysis(string word, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
+    vector<scheme_match> results;
+    analyze(word, hashmap_ptr, tree, results);
+    if (results.empty()) {
+        cout << "✗ No root in the AVL tree produces \"" << word << "\" with a known scheme." << endl;
+        return;
+    }
+    cout << "✓ \"" << word << "\" — " << results.size() << " analysis(es):" << endl;
+    for (const scheme_match& m : results)
+        cout << "  Root: " << m.root << "  |  Scheme: " << m.scheme->key << endl;
+}
+
 void displayMorphologicalFamily(string scheme, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
 
     int pos = search(scheme, hashmap_ptr);
@@ -107,30 +823,40 @@ void displayMorphologicalFamily(string scheme, struct hashmap* hashmap_ptr, Bina
         cout << "✗ Scheme \"" << scheme << "\" not found in hash table." << endl;
         return;
     }
-    struct node* current_node = hashmap_ptr->v[pos];
-    while ( current_node ->key != scheme)  current_node  =  current_node ->next;
-   
-    string algo =  current_node ->value.algo;
-
-    vector<Root> allRoots = tree->getAllRoots();
 
     cout << "\n╔══════════════════════════════════════════════╗" << endl;
     cout << "║  Morphological Family  /  العائلة الصرفية   ║" << endl;
     cout << "║  Scheme: " << scheme << endl;
     cout << "╚══════════════════════════════════════════════╝" << endl;
 
-    bool anyFound = false;
-    for (Root& r : allRoots) {
-        string expectedWord = apply_algo(algo, r.getRoot());
+    vector<derivation> family;
+    tree->derivations().forScheme(scheme, [&](const derivation& d) { family.push_back(d); });
+    const StringPool& pool = StringPool::global();
+    sort(family.begin(), family.end(), [&](const derivation& a, const derivation& b) {
+        return pool.at(a.root) < pool.at(b.root);
+    });
 
-        auto derivs = r.getDerivatives();
-        if (derivs.count(expectedWord)) {
-            anyFound = true;
-            cout << "  Root: " << r.getRoot()
-                 << "  →  Word: " << expectedWord
-                 << "  (freq: " << derivs[expectedWord] << ")" << endl;
-        }
-    }
-    if (!anyFound)
+    for (const derivation& d : family)
+        cout << "  Root: " << pool.at(d.root)
+             << "  →  Word: " << pool.at(d.word)
+             << "  (freq: " << d.count << ")" << endl;
+    if (family.empty())
         cout << "  No validated derivatives found for scheme \"" << scheme << "\"." << endl;
 }
+
+// Producers whose scheme has since been deleted from the table are left out.
+void displayProducers(string word, struct hashmap* hashmap_ptr, BinarySearchTree* tree) {
+    const StringPool& pool = StringPool::global();
+    vector<derivation> producers;
+    tree->derivations().forWord(word, [&](const derivation& d) {
+        if (search(string(pool.at(d.scheme)), hashmap_ptr) != -1) producers.push_back(d);
+    });
+    if (producers.empty()) {
+        cout << "✗ \"" << word << "\" is not a stored derivative of any root." << endl;
+        return;
+    }
+    cout << "✓ \"" << word << "\" — produced by " << producers.size() << " (root, scheme) pair(s):" << endl;
+    for (const derivation& d : producers)
+        cout << "  Root: " << pool.at(d.root) << "  |  Scheme: " << pool.at(d.scheme)
+             << "  (freq: " << d.count << ")" << endl;
+}
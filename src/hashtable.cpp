@@ -1,6 +1,9 @@
 #include "../include/hashtable.h"
 #include <bits/stdc++.h>
 #include <fstream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 
@@ -9,21 +12,181 @@ void setnode(struct node* node, string key, vector<char> abst, string algo) {
     node->key        = key;
     node->value.abst = abst;
     node->value.algo = algo;
-    node->next       = NULL;
 }
 
+// Slot count is a power of two (at least one group) kept at <= 7/8 load;
+// max_element is only the initial sizing hint, the table grows on demand.
 void set_hashmap(struct hashmap* hashmap_ptr, long long max_element) {
-    hashmap_ptr->max_element = max_element;
+    long long slots = HASH_GROUP_WIDTH;
+    while (slots * 7 / 8 < max_element) slots *= 2;
+    hashmap_ptr->pool.clear();
+    hashmap_ptr->max_element = slots * 7 / 8;
     hashmap_ptr->num_element = 0;
-    hashmap_ptr->v.assign(max_element, nullptr);
+    hashmap_ptr->num_deleted = 0;
+    hashmap_ptr->ctrl.assign(slots, CTRL_EMPTY);
+    hashmap_ptr->v.assign(slots, nullptr);
+    hashmap_ptr->old_ctrl.clear();
+    hashmap_ptr->old_v.clear();
+    hashmap_ptr->old_element = 0;
+    hashmap_ptr->migrate_pos = 0;
+    hashmap_ptr->version     = 0;
+    // A table set up again at the same address must not match caches of the old one.
+    static atomic<long long> next_id{0};
+    hashmap_ptr->id          = ++next_id;
 }
 
 
-int hash_function(struct hashmap* hashmap_ptr, string key) {
-    unsigned long long sum = 0;
-    for (int i = 0; i < (int)key.length(); i++)
-        sum += (unsigned char)key[i];
-    return (int)(sum % hashmap_ptr->max_element);
+// 64-bit multiply/xorshift string hash (MurmurHash64A mixing), 8 bytes per step.
+unsigned long long hash_function(string_view key) {
+    const unsigned long long m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    unsigned long long h = 0x9e3779b97f4a7c15ULL ^ (key.length() * m);
+
+    size_t i = 0;
+    for (; i + 8 <= key.length(); i += 8) {
+        unsigned long long k;
+        memcpy(&k, key.data() + i, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (i < key.length()) {
+        unsigned long long tail = 0;
+        for (size_t j = key.length(); j > i; j--)
+            tail = (tail << 8) | (unsigned char)key[j - 1];
+        h ^= tail;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// Bit i of the result is set when ctrl byte i of the group equals b.
+static unsigned int match_group(const signed char* group, signed char b) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b)));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < HASH_GROUP_WIDTH; i++)
+        if (group[i] == b) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+// Empty and deleted bytes are the only ones with the sign bit set.
+static unsigned int match_free(const signed char* group) {
+#ifdef __SSE2__
+    return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < HASH_GROUP_WIDTH; i++)
+        if (group[i] < 0) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+// Triangular probing over whole groups; visits every group once.
+static long long find_slot(const vector<signed char>& ctrl, const vector<struct node*>& v,
+                           const string& key, unsigned long long h, int* groupsVisited = nullptr) {
+    size_t groups = v.size() / HASH_GROUP_WIDTH;
+    if (groups == 0) return -1;
+    size_t g = (h >> 7) & (groups - 1);
+    signed char h2 = (signed char)(h & 0x7f);
+
+    for (size_t i = 0; i < groups; i++) {
+        if (groupsVisited) *groupsVisited = (int)i + 1;
+        const signed char* group = &ctrl[g * HASH_GROUP_WIDTH];
+        unsigned int mask = match_group(group, h2);
+        while (mask) {
+            size_t slot = g * HASH_GROUP_WIDTH + __builtin_ctz(mask);
+            if (v[slot]->key == key) return (long long)slot;
+            mask &= mask - 1;
+        }
+        if (match_group(group, CTRL_EMPTY)) return -1;
+        g = (g + i + 1) & (groups - 1);
+    }
+    return -1;
+}
+
+static long long find_free_slot(const vector<signed char>& ctrl, unsigned long long h) {
+    size_t groups = ctrl.size() / HASH_GROUP_WIDTH;
+    size_t g = (h >> 7) & (groups - 1);
+
+    for (size_t i = 0; i < groups; i++) {
+        unsigned int mask = match_free(&ctrl[g * HASH_GROUP_WIDTH]);
+        if (mask) return (long long)(g * HASH_GROUP_WIDTH + __builtin_ctz(mask));
+        g = (g + i + 1) & (groups - 1);
+    }
+    return -1;
+}
+
+// A probe only continues past a group with no empty byte, so if the slot's
+// group still has one the slot can go straight back to empty.
+static signed char vacated_ctrl(const vector<signed char>& ctrl, long long slot) {
+    long long groupStart = slot - slot % HASH_GROUP_WIDTH;
+    return match_group(&ctrl[groupStart], CTRL_EMPTY) ? CTRL_EMPTY : CTRL_DELETED;
+}
+
+static long long place_node(struct hashmap* hashmap_ptr, struct node* n, unsigned long long h) {
+    long long slot = find_free_slot(hashmap_ptr->ctrl, h);
+    if (hashmap_ptr->ctrl[slot] == CTRL_DELETED) hashmap_ptr->num_deleted--;
+    hashmap_ptr->ctrl[slot] = (signed char)(h & 0x7f);
+    hashmap_ptr->v[slot]    = n;
+    return slot;
+}
+
+// Moves one old entry into the current table.
+static long long migrate_slot(struct hashmap* hashmap_ptr, long long oldSlot) {
+    struct node* n = hashmap_ptr->old_v[oldSlot];
+    hashmap_ptr->old_v[oldSlot]    = NULL;
+    hashmap_ptr->old_ctrl[oldSlot] = CTRL_DELETED;
+    hashmap_ptr->old_element--;
+    return place_node(hashmap_ptr, n, hash_function(n->key));
+}
+
+static void release_old(struct hashmap* hashmap_ptr) {
+    vector<signed char>().swap(hashmap_ptr->old_ctrl);
+    vector<struct node*>().swap(hashmap_ptr->old_v);
+    hashmap_ptr->old_element = 0;
+    hashmap_ptr->migrate_pos = 0;
+}
+
+static void rehash_step(struct hashmap* hashmap_ptr, long long slots) {
+    if (hashmap_ptr->old_v.empty()) return;
+    long long end = min((long long)hashmap_ptr->old_v.size(), hashmap_ptr->migrate_pos + slots);
+    for (long long i = hashmap_ptr->migrate_pos; i < end && hashmap_ptr->old_element > 0; i++)
+        if (hashmap_ptr->old_v[i] != NULL) migrate_slot(hashmap_ptr, i);
+    hashmap_ptr->migrate_pos = end;
+    if (hashmap_ptr->old_element == 0 || end == (long long)hashmap_ptr->old_v.size())
+        release_old(hashmap_ptr);
+}
+
+void complete_rehash(struct hashmap* hashmap_ptr) {
+    rehash_step(hashmap_ptr, (long long)hashmap_ptr->old_v.size());
+}
+
+// Swaps in an empty table (twice the size unless the load is mostly
+// tombstones) and leaves the current arrays to be drained by rehash_step.
+static void start_grow(struct hashmap* hashmap_ptr) {
+    complete_rehash(hashmap_ptr);
+
+    long long slots = (long long)hashmap_ptr->v.size();
+    if (hashmap_ptr->num_element * 2 >= slots) slots *= 2;
+
+    hashmap_ptr->old_ctrl.swap(hashmap_ptr->ctrl);
+    hashmap_ptr->old_v.swap(hashmap_ptr->v);
+    hashmap_ptr->old_element = hashmap_ptr->num_element;
+    hashmap_ptr->migrate_pos = 0;
+
+    hashmap_ptr->ctrl.assign(slots, CTRL_EMPTY);
+    hashmap_ptr->v.assign(slots, nullptr);
+    hashmap_ptr->num_deleted = 0;
+    hashmap_ptr->max_element = slots * 7 / 8;
 }
 
 vector<char> abst_function(string key){
@@ -43,97 +206,122 @@ string algo_function(string key) {
     string ch = "";
     int rootLetterIdx = 0;
 
-    for (int i = 0; i < (int)key.length()-1; i += 2) {       
-            string twoBytes = key.substr(i, 2);// arabic caracters are written in two bytes
-            if (twoBytes == FA || twoBytes == AIN || twoBytes == LAM) {
-                ch += "root[" + to_string(rootLetterIdx) + "]";
-                rootLetterIdx++;
-            } else {
-                ch += twoBytes;
-            }
-       
-      
-    
+    size_t i = 0;
+    while (i < key.length()) {
+        unsigned char lead = (unsigned char)key[i];
+        size_t len = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        string letter = key.substr(i, len);
+        if (letter == FA || letter == AIN || letter == LAM) {
+            ch += "root[" + to_string(rootLetterIdx) + "]";
+            rootLetterIdx++;
+        } else {
+            ch += letter;
+        }
+        i += len;
     }
     return ch;
 }
 
+// Same substitution as algo_function, but as an op list: consecutive
+// literal letters are merged into one run of lits.
+void compile_scheme(const string& key, struct inside* value) {
+    value->lits.clear();
+    value->ops.clear();
+    value->slots = 0;
+
+    size_t i = 0;
+    while (i < key.length()) {
+        unsigned char lead = (unsigned char)key[i];
+        size_t len = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        len = min(len, key.length() - i);
+
+        bool placeholder = len == 2 && (key.compare(i, 2, "\xd9\x81") == 0    // ف
+                                        || key.compare(i, 2, "\xd8\xb9") == 0 // ع
+                                        || key.compare(i, 2, "\xd9\x84") == 0); // ل
+        if (placeholder) {
+            value->ops.push_back({(unsigned char)value->slots, 0, 0});
+            value->slots++;
+        } else {
+            if (value->ops.empty() || value->ops.back().slot != SCHEME_LITERAL)
+                value->ops.push_back({SCHEME_LITERAL, (unsigned short)value->lits.length(), 0});
+            value->lits.append(key, i, len);
+            value->ops.back().length += (unsigned short)len;
+        }
+        i += len;
+    }
+}
+
 
 void insert(struct hashmap* hashmap_ptr, string key) {
-    if (hashmap_ptr->num_element >= hashmap_ptr->max_element) {
-        cout << "Database is full." << endl;
+    rehash_step(hashmap_ptr, HASH_MIGRATE_SLOTS);
+
+    if (search(key, hashmap_ptr) != -1) {
+        cout << "✗ Scheme \"" << key << "\" already exists." << endl;
         return;
     }
 
-    int hash_value = hash_function(hashmap_ptr, key);
+    if (hashmap_ptr->num_element + hashmap_ptr->num_deleted + 1 > hashmap_ptr->max_element)
+        start_grow(hashmap_ptr);
 
-    struct node* new_node = new struct node();
+    struct node* new_node = hashmap_ptr->pool.create();
     setnode(new_node, key, abst_function(key), algo_function(key));
+    compile_scheme(key, &new_node->value);
 
-    if (hashmap_ptr->v[hash_value] == NULL) {
-        hashmap_ptr->v[hash_value] = new_node;
-    } else {
-     
-        struct node* current_node = hashmap_ptr->v[hash_value];
-        while (current_node->next != NULL)
-            current_node = current_node->next;
-        current_node->next = new_node;
-    }
-
+    place_node(hashmap_ptr, new_node, hash_function(key));
     hashmap_ptr->num_element++;
+    hashmap_ptr->version++;
 }
 
+// Slot of key, or -1. Read-only: an entry still waiting in the old table
+// is reported as v.size() + its old slot and left where it is, so lookups
+// never move entries; only insert and del drive the migration.
 int search(string key, struct hashmap* hashmap_ptr) {
-    int hash_value = hash_function(hashmap_ptr, key);
-    struct node* current_node = hashmap_ptr->v[hash_value];
-    while (current_node != NULL) {
-        if (current_node->key == key)
-            return hash_value;
-        current_node = current_node->next;
+    unsigned long long h = hash_function(key);
+    long long slot = find_slot(hashmap_ptr->ctrl, hashmap_ptr->v, key, h);
+    if (slot == -1 && hashmap_ptr->old_element > 0) {
+        long long oldSlot = find_slot(hashmap_ptr->old_ctrl, hashmap_ptr->old_v, key, h);
+        if (oldSlot != -1) slot = (long long)hashmap_ptr->v.size() + oldSlot;
     }
-    return -1;
+    return (int)slot;
+}
+
+struct node* find_scheme(const string& key, const struct hashmap* hashmap_ptr) {
+    unsigned long long h = hash_function(key);
+    long long slot = find_slot(hashmap_ptr->ctrl, hashmap_ptr->v, key, h);
+    if (slot != -1) return hashmap_ptr->v[slot];
+    if (hashmap_ptr->old_element == 0) return NULL;
+    slot = find_slot(hashmap_ptr->old_ctrl, hashmap_ptr->old_v, key, h);
+    return slot == -1 ? NULL : hashmap_ptr->old_v[slot];
+}
+
+// Current table first, then whatever still waits in the old one.
+vector<struct node*> all_schemes(const struct hashmap* hashmap_ptr) {
+    vector<struct node*> schemes;
+    schemes.reserve(hashmap_ptr->num_element);
+    for (struct node* n : hashmap_ptr->v)
+        if (n != NULL) schemes.push_back(n);
+    for (struct node* n : hashmap_ptr->old_v)
+        if (n != NULL) schemes.push_back(n);
+    return schemes;
 }
 
 void del (string key,struct hashmap* hashmap_ptr)
 {
+    rehash_step(hashmap_ptr, HASH_MIGRATE_SLOTS);
     int result = search(key,hashmap_ptr);
     if(result == -1){
         cout<<"impossible !"<<endl;
         return;
     }
-    if(hashmap_ptr->v[result]->key== key){
-        if(hashmap_ptr->v[result]->next != NULL){
-            struct node* temp = hashmap_ptr->v[result]->next;
-            delete hashmap_ptr->v[result];
-            hashmap_ptr->v[result]=temp;
-            hashmap_ptr->num_element--;
-        }
-        else {
-             delete hashmap_ptr->v[result];
-             hashmap_ptr->v[result]=NULL;
-        }
-       
-    }
-    else {
-        struct node* current_node = hashmap_ptr->v[result];
-        struct node* prev_node = NULL;                          
-            while(current_node->next!= NULL){
-                prev_node = current_node;                       
-                current_node = current_node->next;
-                if(current_node->key == key){
-                    if(current_node->next== NULL){
-                        delete current_node;
-                        current_node = NULL;
-                        prev_node->next = NULL;                 
-                    }
-                    else{
-                        struct node* temp = current_node->next;
-                        delete current_node;
-                        current_node =temp;
-                        prev_node->next = temp;
-                    }
-            }}
-    }
+    if (result >= (int)hashmap_ptr->v.size())
+        result = (int)migrate_slot(hashmap_ptr, result - (long long)hashmap_ptr->v.size());
+    hashmap_ptr->pool.destroy(hashmap_ptr->v[result]);
+    hashmap_ptr->v[result] = NULL;
+
+    hashmap_ptr->ctrl[result] = vacated_ctrl(hashmap_ptr->ctrl, result);
+    if (hashmap_ptr->ctrl[result] == CTRL_DELETED) hashmap_ptr->num_deleted++;
+    hashmap_ptr->num_element--;
+    hashmap_ptr->version++;
 }
 void update(string oldKey, string newKey, struct hashmap* hashmap_ptr) {
     
@@ -156,17 +344,78 @@ void printAll(struct hashmap* hashmap_ptr) {
     if (hashmap_ptr->num_element==0){ 
          cout << "The database is empty." << endl;
          return;}
-    for (int i = 0; i < (int)hashmap_ptr->v.size(); i++) {
-        struct node* current_node = hashmap_ptr->v[i];
-        while (current_node != NULL) {
-            cout << "  [" << i << "] key = " << current_node->key
-                 << "  |  algo = " << current_node->value.algo << endl;
-            current_node = current_node->next;
-         
+    // Entries still in the old table are numbered after the current slots, as search() reports them.
+    const vector<struct node*>* tables[2] = {&hashmap_ptr->v, &hashmap_ptr->old_v};
+    size_t base = 0;
+    for (const vector<struct node*>* table : tables) {
+        for (size_t i = 0; i < table->size(); i++) {
+            struct node* current_node = (*table)[i];
+            if (current_node != NULL)
+                cout << "  [" << base + i << "] key = " << current_node->key
+                     << "  |  algo = " << current_node->value.algo << endl;
         }
+        base += table->size();
     }
 }
 
+// Probe lengths of the open-addressing table next to what the old chained
+// table (byte-sum hash, one bucket per slot) would give for the same keys.
+void printStats(struct hashmap* hashmap_ptr) {
+    long long n = hashmap_ptr->num_element;
+    if (n == 0) {
+        cout << "The database is empty." << endl;
+        return;
+    }
+
+    // Read-only: entries still in the old table are measured against its own ctrl bytes.
+    long long groupsTotal = 0;
+    int groupsMax = 0;
+    long long h2Collisions = 0;
+    map<long long, long long> chainLen;
+    auto measure = [&](const vector<signed char>& ctrl, const vector<struct node*>& v) {
+        for (int i = 0; i < (int)v.size(); i++) {
+            struct node* current_node = v[i];
+            if (current_node == NULL) continue;
+
+            int groups = 0;
+            unsigned long long h = hash_function(current_node->key);
+            find_slot(ctrl, v, current_node->key, h, &groups);
+            groupsTotal += groups;
+            groupsMax = max(groupsMax, groups);
+
+            long long groupStart = i - i % HASH_GROUP_WIDTH;
+            h2Collisions += __builtin_popcount(match_group(&ctrl[groupStart], ctrl[i])) - 1;
+
+            unsigned long long sum = 0;
+            for (unsigned char c : current_node->key) sum += c;
+            chainLen[(long long)(sum % hashmap_ptr->v.size())]++;
+        }
+    };
+    measure(hashmap_ptr->ctrl, hashmap_ptr->v);
+    measure(hashmap_ptr->old_ctrl, hashmap_ptr->old_v);
+
+    long long chainCompares = 0, chainMax = 0;
+    for (auto& b : chainLen) {
+        chainCompares += b.second * (b.second + 1) / 2;
+        chainMax = max(chainMax, b.second);
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "  Schemes                   : " << n << endl;
+    cout << "  Slots / load factor       : " << hashmap_ptr->v.size() << " / "
+         << (double)n / hashmap_ptr->v.size() << endl;
+    cout << "  Open addressing (16-wide groups, 64-bit hash)" << endl;
+    cout << "    avg / max groups probed : " << (double)groupsTotal / n << " / " << groupsMax << endl;
+    cout << "    extra tag-match compares: " << h2Collisions << endl;
+    cout << "  Chained (byte-sum hash, " << hashmap_ptr->v.size() << " buckets)" << endl;
+    cout << "    colliding keys          : " << n - (long long)chainLen.size() << endl;
+    cout << "    avg / max keys compared : " << (double)chainCompares / n << " / " << chainMax << endl;
+    pool_stats ps = hashmap_ptr->pool.stats();
+    cout << "  Node pool                 : " << ps.live << " live, " << ps.free_slots << " free, "
+         << ps.slabs << " slab(s), " << ps.bytes / 1024 << " KB" << endl;
+    cout << defaultfloat;
+}
+
 void loadFromFile(struct hashmap* hashmap_ptr) {
     string filename;
     cout << "Enter the file path : ";
@@ -186,11 +435,6 @@ void loadFromFile(struct hashmap* hashmap_ptr) {
 
         if (scheme.empty()) continue;
 
-        if (hashmap_ptr->num_element == hashmap_ptr->max_element) {
-            cout << "Database is full. Stopped after inserting " << count << " schemes." << endl;
-            file.close();
-            return;
-        }
         insert(hashmap_ptr, scheme);
         count++;
     }